@@ -0,0 +1,268 @@
+/*
+ *	Decoder micro-benchmark
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include <elm/io.h>
+#include <elm/io/OutFileStream.h>
+#include <elm/data/Vector.h>
+
+#include <gel++.h>
+#include <gel++/Image.h>
+
+#include <otawa/prog/Decoder.h>
+#include <otawa/prog/Inst.h>
+
+#include "../x86.h"
+
+using namespace elm;
+using namespace otawa;
+
+/*
+ * usage: bench_decoder [-r REPEAT] [-e ENGINE]... [-o OUTPUT] FILE...
+ *
+ * For each file and each engine (x86, x86-lazy, i.e. with operands decoded
+ * on demand, and zydis by default), a fresh
+ * decoder decodes all executable segments with Decoder::decodeRange()
+ * (cold pass) then decodes them again (warm pass, answered by the
+ * instruction cache). Each measure is repeated REPEAT times and the
+ * minimum and median times are reported, as well as the memory footprint
+ * after the cold pass and after a predecoding (Decoder::predecode()) of
+ * the executable segments with a fresh decoder. The result is written as JSON
+ * on the standard output or in OUTPUT.
+ */
+
+// allocation counting
+static std::atomic<t::uint64> alloc_count(0);
+
+void *operator new(std::size_t size) {
+	alloc_count++;
+	void *p = std::malloc(size == 0 ? 1 : size);
+	if(p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+
+// engines
+typedef otawa::Decoder *(*maker_t)(gel::Image *image, otawa::x86::mode_t mode, bool stats);
+
+typedef struct engine_t {
+	cstring name;
+	maker_t make;
+} engine_t;
+
+static otawa::Decoder *makeFull(gel::Image *image, otawa::x86::mode_t mode, bool stats) {
+	return otawa::x86::makeDecoder(image, mode, stats);
+}
+
+static otawa::Decoder *makeLazy(gel::Image *image, otawa::x86::mode_t mode, bool stats) {
+	return otawa::x86::makeDecoder(image, mode, stats, true);
+}
+
+static const engine_t engines[] = {
+	{ "x86", makeFull },
+	{ "x86-lazy", makeLazy },
+	{ "zydis", otawa::x86::makeZydisDecoder }
+};
+static const int engine_count = sizeof(engines) / sizeof(engine_t);
+
+
+// sink counting the instructions
+class CountSink: public otawa::Decoder::Sink {
+public:
+	CountSink(): count(0), bytes(0) { }
+	void put(Inst *inst) override { count++; bytes += inst->size(); }
+	t::uint64 count, bytes;
+};
+
+typedef std::chrono::steady_clock steady;
+
+static t::uint64 decodeAll(otawa::Decoder *dec, gel::Image *image, CountSink& sink) {
+	auto start = steady::now();
+	for(auto s: image->segments())
+		if(s->isExecutable())
+			dec->decodeRange(s->base(), s->base() + s->size(), sink);
+	auto stop = steady::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+}
+
+// memory footprint after a predecoding of the executable segments
+static t::size predecodeAll(otawa::Decoder *dec, gel::Image *image) {
+	Vector<gel::address_t> starts;
+	for(auto s: image->segments())
+		if(s->isExecutable())
+			dec->predecode(s->base(), s->base() + s->size(), starts, 1);
+	return dec->footprint();
+}
+
+static t::uint64 median(Vector<t::uint64>& v) {
+	std::sort(&v[0], &v[0] + v.count());
+	return v[v.count() / 2];
+}
+
+static t::uint64 minimum(const Vector<t::uint64>& v) {
+	return *std::min_element(&v[0], &v[0] + v.count());
+}
+
+static void putTime(io::Output& out, cstring name, Vector<t::uint64>& times, t::uint64 insts) {
+	t::uint64 best = minimum(times), med = median(times);
+	out << "\t\t\t\"" << name << "\": {"
+		<< " \"min_ns\": " << best
+		<< ", \"median_ns\": " << med
+		<< ", \"ns_per_inst\": " << (insts == 0 ? 0. : double(med) / insts)
+		<< ", \"insts_per_s\": " << (med == 0 ? 0. : insts * 1e9 / med)
+		<< " }";
+}
+
+static void bench(io::Output& out, cstring path, const engine_t& engine, int repeat, bool& first) {
+	auto file = gel::Manager::open(path);
+	auto image = file->make();
+
+	Vector<t::uint64> cold, warm;
+	t::uint64 insts = 0, bytes = 0, allocs = 0, footprint = 0;
+	for(int i = 0; i < repeat; i++) {
+		CountSink csink, wsink;
+		t::uint64 a = alloc_count;
+		auto dec = engine.make(image, otawa::x86::MODE_PROTECT, false);
+		cold.add(decodeAll(dec, image, csink));
+		allocs = alloc_count - a;
+		warm.add(decodeAll(dec, image, wsink));
+		insts = csink.count;
+		bytes = csink.bytes;
+		footprint = dec->footprint();
+		delete dec;
+	}
+	auto dec = engine.make(image, otawa::x86::MODE_PROTECT, false);
+	t::size pfootprint = predecodeAll(dec, image);
+	delete dec;
+
+	if(!first)
+		out << ",\n";
+	first = false;
+	out << "\t\t{\n"
+		<< "\t\t\t\"file\": \"" << path << "\",\n"
+		<< "\t\t\t\"engine\": \"" << engine.name << "\",\n"
+		<< "\t\t\t\"insts\": " << insts << ",\n"
+		<< "\t\t\t\"bytes\": " << bytes << ",\n"
+		<< "\t\t\t\"allocs_per_inst\": " << (insts == 0 ? 0. : double(allocs) / insts) << ",\n"
+		<< "\t\t\t\"footprint_per_inst\": " << (insts == 0 ? 0. : double(footprint) / insts) << ",\n"
+		<< "\t\t\t\"predecode_footprint_per_inst\": " << (insts == 0 ? 0. : double(pfootprint) / insts) << ",\n";
+	putTime(out, "cold", cold, insts);
+	out << ",\n";
+	putTime(out, "warm", warm, insts);
+	out << "\n\t\t}";
+
+	delete image;
+	delete file;
+}
+
+static void usage() {
+	cerr << "usage: bench_decoder [-r REPEAT] [-e ENGINE]... [-o OUTPUT] FILE...\n";
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	int repeat = 5;
+	cstring output;
+	Vector<const engine_t *> used;
+	Vector<cstring> files;
+
+	// parse arguments
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg == "-r" && i + 1 < argc)
+			repeat = atoi(argv[++i]);
+		else if(arg == "-o" && i + 1 < argc)
+			output = argv[++i];
+		else if(arg == "-e" && i + 1 < argc) {
+			cstring name = argv[++i];
+			const engine_t *e = nullptr;
+			for(int j = 0; j < engine_count; j++)
+				if(name == engines[j].name)
+					e = &engines[j];
+			if(e == nullptr) {
+				cerr << "ERROR: unknown engine " << name << io::endl;
+				usage();
+			}
+			used.add(e);
+		}
+		else if(arg.startsWith("-"))
+			usage();
+		else
+			files.add(argv[i]);
+	}
+	if(files.isEmpty() || repeat <= 0)
+		usage();
+	if(used.isEmpty())
+		for(int j = 0; j < engine_count; j++)
+			used.add(&engines[j]);
+
+	// run the benchmarks
+	io::OutStream *stream = &io::out;
+	if(!output.isEmpty())
+		stream = new io::OutFileStream(output);
+	io::Output out(*stream);
+	try {
+		bool first = true;
+		out << "{\n\t\"benchmark\": \"decoder\",\n\t\"repeat\": " << repeat << ",\n\t\"results\": [\n";
+		for(auto f: files)
+			for(auto e: used)
+				bench(out, f, *e, repeat, first);
+		out << "\n\t]\n}\n";
+	}
+	catch(gel::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+		return 1;
+	}
+	catch(otawa::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+		return 1;
+	}
+	out.flush();
+	if(stream != &io::out)
+		delete stream;
+	return 0;
+}
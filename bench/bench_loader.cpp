@@ -0,0 +1,285 @@
+/*
+ *	Loader scaling benchmark
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <elm/io.h>
+#include <elm/io/OutFileStream.h>
+#include <elm/data/Vector.h>
+
+#include <otawa/prog/DefaultLoader.h>
+#include <otawa/prog/Process.h>
+#include <otawa/otawa.h>
+
+using namespace elm;
+using namespace otawa;
+
+/*
+ * usage: bench_loader [-p] [-o OUTPUT] FILE...
+ *
+ * Each file is loaded in its own process with DefaultLoader::load()
+ * followed by a call to Process::start(). The wall time and the resident
+ * set size at the end of each load phase (see LoadObserver) and the peak
+ * resident set size are recorded. With -p, the executable segments are
+ * pre-decoded (PREDECODE).
+ *
+ * The files are expected in increasing size order: the report ends with,
+ * for each phase, the exponent k of the best fit time = c * size^k
+ * (least squares on log-log scale) and the exponent between consecutive
+ * files, k ~ 1 meaning linear scaling.
+ */
+
+const int MAX_PHASES = 16;
+
+typedef struct phase_t {
+	char name[16];
+	t::uint64 ns;
+	t::uint64 rss_kb;
+} phase_t;
+
+typedef struct run_t {
+	int status;
+	int count;
+	t::uint64 size;
+	t::uint64 peak_kb;
+	phase_t phases[MAX_PHASES];
+} run_t;
+
+// current resident set size in KB
+static t::uint64 currentRSS() {
+	unsigned long pages = 0, resident = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if(f == nullptr)
+		return 0;
+	if(fscanf(f, "%lu %lu", &pages, &resident) != 2)
+		resident = 0;
+	fclose(f);
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// observer recording the phases
+class Recorder: public LoadObserver {
+public:
+	Recorder(run_t& run): _run(run) { }
+
+	void beginPhase(cstring name) override {
+		_start = std::chrono::steady_clock::now();
+	}
+
+	void endPhase(cstring name) override {
+		auto stop = std::chrono::steady_clock::now();
+		if(_run.count == MAX_PHASES)
+			return;
+		auto& p = _run.phases[_run.count++];
+		strncpy(p.name, name.chars(), sizeof(p.name) - 1);
+		p.name[sizeof(p.name) - 1] = '\0';
+		p.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - _start).count();
+		p.rss_kb = currentRSS();
+	}
+
+private:
+	run_t& _run;
+	std::chrono::steady_clock::time_point _start;
+};
+
+// load the file in the current process
+static void load(cstring path, bool predecode, run_t& run) {
+	Recorder rec(run);
+	PropList props;
+	LOAD_OBSERVER(props) = &rec;
+	PREDECODE(props) = predecode;
+	Loader::make maker("bench", OTAWA_LOADER_VERSION);
+	DefaultLoader loader(maker);
+	try {
+		auto proc = loader.load(&MANAGER, path, props);
+		proc->start();
+		run.status = 0;
+	}
+	catch(otawa::Exception& e) {
+		cerr << "ERROR: " << path << ": " << e.message() << io::endl;
+		run.status = 1;
+	}
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	run.peak_kb = usage.ru_maxrss;
+}
+
+// load the file in a child process to get its own peak RSS
+static bool measure(cstring path, bool predecode, run_t& run) {
+	memset(&run, 0, sizeof(run));
+	struct stat st;
+	if(stat(path.chars(), &st) != 0) {
+		cerr << "ERROR: cannot access " << path << io::endl;
+		return false;
+	}
+	run.size = st.st_size;
+
+	int fds[2];
+	if(pipe(fds) != 0)
+		return false;
+	cout.flush();
+	cerr.flush();
+	pid_t pid = fork();
+	if(pid < 0)
+		return false;
+	if(pid == 0) {
+		close(fds[0]);
+		load(path, predecode, run);
+		bool ok = write(fds[1], &run, sizeof(run)) == ssize_t(sizeof(run));
+		close(fds[1]);
+		_exit(ok ? 0 : 1);
+	}
+	close(fds[1]);
+	bool ok = read(fds[0], &run, sizeof(run)) == ssize_t(sizeof(run));
+	close(fds[0]);
+	int status;
+	waitpid(pid, &status, 0);
+	return ok && run.status == 0;
+}
+
+static t::uint64 phaseTime(const run_t& run, cstring name) {
+	for(int i = 0; i < run.count; i++)
+		if(name == run.phases[i].name)
+			return run.phases[i].ns;
+	return 0;
+}
+
+static t::uint64 totalTime(const run_t& run) {
+	t::uint64 t = 0;
+	for(int i = 0; i < run.count; i++)
+		t += run.phases[i].ns;
+	return t;
+}
+
+// least squares slope of log(time) against log(size)
+static double fit(const Vector<run_t>& runs, const Vector<t::uint64>& times) {
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	int n = 0;
+	for(int i = 0; i < runs.count(); i++)
+		if(times[i] != 0) {
+			double x = std::log(double(runs[i].size)), y = std::log(double(times[i]));
+			sx += x; sy += y; sxx += x * x; sxy += x * y;
+			n++;
+		}
+	double d = n * sxx - sx * sx;
+	return n < 2 || d == 0 ? 0. : (n * sxy - sx * sy) / d;
+}
+
+static void putScaling(io::Output& out, cstring name, const Vector<run_t>& runs, const Vector<t::uint64>& times) {
+	out << "\t\t\"" << name << "\": { \"exponent\": " << fit(runs, times) << ", \"steps\": [";
+	for(int i = 1; i < runs.count(); i++) {
+		if(i > 1)
+			out << ", ";
+		if(times[i - 1] == 0 || times[i] == 0 || runs[i].size == runs[i - 1].size)
+			out << "null";
+		else
+			out << std::log(double(times[i]) / times[i - 1]) / std::log(double(runs[i].size) / runs[i - 1].size);
+	}
+	out << "] }";
+}
+
+static void usage() {
+	cerr << "usage: bench_loader [-p] [-o OUTPUT] FILE...\n";
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	bool predecode = false;
+	cstring output;
+	Vector<cstring> files;
+
+	// parse arguments
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg == "-p")
+			predecode = true;
+		else if(arg == "-o" && i + 1 < argc)
+			output = argv[++i];
+		else if(arg.startsWith("-"))
+			usage();
+		else
+			files.add(argv[i]);
+	}
+	if(files.isEmpty())
+		usage();
+
+	// perform the measures
+	Vector<run_t> runs;
+	Vector<cstring> paths;
+	for(auto f: files) {
+		run_t run;
+		if(!measure(f, predecode, run))
+			return 1;
+		runs.add(run);
+		paths.add(f);
+	}
+
+	// output the results
+	io::OutStream *stream = &io::out;
+	if(!output.isEmpty())
+		stream = new io::OutFileStream(output);
+	io::Output out(*stream);
+	out << "{\n\t\"benchmark\": \"loader\",\n\t\"predecode\": " << (predecode ? "true" : "false") << ",\n\t\"runs\": [\n";
+	for(int i = 0; i < runs.count(); i++) {
+		const run_t& r = runs[i];
+		out << "\t\t{\n"
+			<< "\t\t\t\"file\": \"" << paths[i] << "\",\n"
+			<< "\t\t\t\"size\": " << r.size << ",\n"
+			<< "\t\t\t\"total_ns\": " << totalTime(r) << ",\n"
+			<< "\t\t\t\"peak_rss_kb\": " << r.peak_kb << ",\n"
+			<< "\t\t\t\"phases\": {\n";
+		for(int j = 0; j < r.count; j++) {
+			out << "\t\t\t\t\"" << r.phases[j].name << "\": { \"ns\": " << r.phases[j].ns
+				<< ", \"rss_kb\": " << r.phases[j].rss_kb << " }";
+			out << (j + 1 < r.count ? ",\n" : "\n");
+		}
+		out << "\t\t\t}\n\t\t}" << (i + 1 < runs.count() ? ",\n" : "\n");
+	}
+
+	// scaling of each phase of the first run and of the total
+	out << "\t],\n\t\"scaling\": {\n";
+	Vector<t::uint64> times;
+	for(int j = 0; j < runs[0].count; j++) {
+		cstring name = runs[0].phases[j].name;
+		times.clear();
+		for(const auto& r: runs)
+			times.add(phaseTime(r, name));
+		putScaling(out, name, runs, times);
+		out << ",\n";
+	}
+	times.clear();
+	for(const auto& r: runs)
+		times.add(totalTime(r));
+	putScaling(out, "total", runs, times);
+	out << "\n\t}\n}\n";
+
+	out.flush();
+	if(stream != &io::out)
+		delete stream;
+	return 0;
+}
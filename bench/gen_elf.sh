@@ -0,0 +1,80 @@
+#!/bin/sh
+#
+#	Generate a synthetic i386 ELF executable for benchmarking.
+#
+#	This file is part of x86 plug-in for OTAWA.
+#	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+#
+#	OTAWA is free software; you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation; either version 2 of the License, or
+#	(at your option) any later version.
+#
+#	OTAWA is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with OTAWA; if not, write to the Free Software
+#	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# usage: gen_elf.sh OUTPUT FUNCTIONS STATEMENTS [DATA]
+#	OUTPUT		path of the produced executable
+#	FUNCTIONS	number of generated functions (one FUNC symbol each)
+#	STATEMENTS	number of statements per function
+#	DATA		number of initialized data arrays (one OBJECT symbol each, default 0)
+#
+# The program does not need any C library: it is built freestanding with
+# its own _start. The C compiler is taken from $CC (default cc) and must
+# support -m32.
+
+set -e
+if [ $# -lt 3 -o $# -gt 4 ]; then
+	echo "usage: $0 OUTPUT FUNCTIONS STATEMENTS [DATA]" >&2
+	exit 1
+fi
+out="$1"
+funs="$2"
+stats="$3"
+data="${4:-0}"
+src="$out.c"
+
+awk -v funs="$funs" -v stats="$stats" -v data="$data" 'BEGIN {
+	print "int g[256];"
+	print "unsigned short h[256];"
+	print "unsigned char c[256];"
+	for(d = 0; d < data; d++)
+		printf "int d%d[4] = { %d, %d, %d, %d };\n", d, d, d + 1, d + 2, d + 3
+	for(f = 0; f < funs; f++) {
+		printf "int f%d(int a, int b) {\n", f
+		print "\tint r = a, i;"
+		for(s = 0; s < stats; s++) {
+			k = (f * 7 + s) % 10
+			if(k == 0)		printf "\tr = r * %d + b;\n", s + 3
+			else if(k == 1)	printf "\tif(r & %d) r ^= b; else r -= a;\n", s + 1
+			else if(k == 2)	printf "\tg[(r + %d) & 255] = r;\n", s
+			else if(k == 3)	printf "\tr += h[(b + %d) & 255] + c[r & 255];\n", s
+			else if(k == 4)	printf "\tr = (r << %d) | ((unsigned)r >> %d);\n", s % 31 + 1, 31 - s % 31
+			else if(k == 5)	printf "\tif(b != 0) r = r / (b | 1) + r %% %d;\n", s + 2
+			else if(k == 6)	printf "\tfor(i = 0; i < (a & 7); i++) r += g[i + %d];\n", s % 248
+			else if(k == 7)	printf "\th[r & 255] = (unsigned short)(r >> %d);\n", s % 16
+			else if(k == 8 && f > 0)
+							printf "\tr += f%d(r, %d);\n", (f + s) % f, s
+			else			printf "\tc[b & 255] = (unsigned char)(r + %d);\n", s
+		}
+		print "\treturn r;"
+		print "}"
+	}
+	print "void _start(void) {"
+	print "\tvolatile int x = 0;"
+	for(f = 0; f < funs; f++)
+		printf "\tx += f%d(x, %d);\n", f, f
+	print "\t__asm__ volatile(\"int $0x80\" :: \"a\"(1), \"b\"(0));"
+	print "\tfor(;;);"
+	print "}"
+}' > "$src"
+
+${CC:-cc} -m32 -O1 -fno-inline -ffreestanding -fno-pic -no-pie -fno-stack-protector \
+	-nostdlib -static -o "$out" "$src"
+rm -f "$src"
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+#	Measure the scaling of the loader on synthetic i386 executables.
+#
+#	This file is part of x86 plug-in for OTAWA.
+#	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+#
+#	OTAWA is free software; you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation; either version 2 of the License, or
+#	(at your option) any later version.
+#
+#	OTAWA is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with OTAWA; if not, write to the Free Software
+#	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# usage: scale_loader.sh BENCH_LOADER DIRECTORY [FUNCTIONS...]
+#	BENCH_LOADER	path to the bench_loader executable
+#	DIRECTORY		directory receiving the generated executables and the results
+#	FUNCTIONS		function counts of the generated executables
+#					(default 250 500 1000 2000 4000 8000)
+#
+# Each executable has FUNCTIONS functions of 10 statements and 4 * FUNCTIONS
+# data symbols. The results are written to DIRECTORY/bench_loader.json
+# (load only) and DIRECTORY/bench_loader_predecode.json (with PREDECODE).
+
+set -e
+if [ $# -lt 2 ]; then
+	echo "usage: $0 BENCH_LOADER DIRECTORY [FUNCTIONS...]" >&2
+	exit 1
+fi
+bench="$1"
+dir="$2"
+shift 2
+sizes="${*:-250 500 1000 2000 4000 8000}"
+here=`dirname "$0"`
+
+mkdir -p "$dir"
+files=""
+for n in $sizes; do
+	elf="$dir/scale-$n.elf"
+	if [ ! -f "$elf" ]; then
+		echo "generating $elf"
+		sh "$here/gen_elf.sh" "$elf" $n 10 `expr 4 \* $n`
+	fi
+	files="$files $elf"
+done
+
+"$bench" -o "$dir/bench_loader.json" $files
+"$bench" -p -o "$dir/bench_loader_predecode.json" $files
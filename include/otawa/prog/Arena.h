@@ -0,0 +1,65 @@
+/*
+ *	Arena class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_ARENA_H
+#define OTAWA_PROG_ARENA_H
+
+#include <elm/types.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class Arena {
+public:
+	static const t::size DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	Arena(t::size block_size = DEFAULT_BLOCK_SIZE);
+	~Arena();
+
+	inline void *allocate(t::size size, t::size align = sizeof(void *)) {
+		t::uintptr p = (t::uintptr(_top) + align - 1) & ~t::uintptr(align - 1);
+		if(p + size > t::uintptr(_end))
+			return allocateBlock(size, align);
+		_top = reinterpret_cast<char *>(p + size);
+		_used += size;
+		return reinterpret_cast<void *>(p);
+	}
+
+	void clear();
+	inline t::size footprint() const { return _reserved; }
+	inline t::size used() const { return _used; }
+
+private:
+	void *allocateBlock(t::size size, t::size align);
+
+	typedef struct block_t {
+		struct block_t *next;
+	} block_t;
+
+	t::size _bsize;
+	block_t *_blocks;
+	char *_top, *_end;
+	t::size _reserved, _used;
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_ARENA_H
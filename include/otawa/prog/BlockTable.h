@@ -0,0 +1,124 @@
+/*
+ *	BlockTable class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_BLOCK_TABLE_H
+#define OTAWA_PROG_BLOCK_TABLE_H
+
+#include <elm/types.h>
+#include <elm/data/Vector.h>
+#include <gel++.h>
+#include <otawa/prog/Inst.h>
+#include <otawa/prog/SegmentIndex.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class BlockTable {
+public:
+	static const t::uint32 NO_BLOCK = 0xffffffff;
+
+	typedef enum {
+		FALL = 0,		// fall-through to the next instruction
+		TAKEN = 1,		// taken branch
+		CALL = 2		// sub-program call
+	} edge_kind_t;
+
+	class Edge {
+		friend class BlockTable;
+	public:
+		inline t::uint32 source() const { return _source; }
+		inline t::uint32 target() const { return _target; }
+		inline edge_kind_t kind() const { return edge_kind_t(_kind); }
+		inline bool isResolved() const { return _target != NO_BLOCK; }
+	private:
+		t::uint32 _source, _target;
+		t::uint32 _kind;
+	};
+
+	class Block {
+		friend class BlockTable;
+	public:
+		inline gel::address_t address() const { return _base; }
+		inline gel::address_t top() const { return _top; }
+		inline t::uint32 size() const { return _top - _base; }
+		inline int count() const { return _count; }
+		inline Inst::kind_t kind() const { return _kind; }
+		inline bool isEntry() const { return _entry; }
+		inline bool contains(gel::address_t a) const { return _base <= a && a < _top; }
+		inline int edgeCount() const { return _ecount; }
+	private:
+		gel::address_t _base, _top;
+		t::uint32 _first, _count;
+		t::uint32 _edge, _ecount;
+		Inst::kind_t _kind;
+		bool _entry;
+	};
+
+	BlockTable(const SegmentIndex& segments);
+	~BlockTable();
+
+	// discovery
+	void entry(gel::address_t a);
+	bool next(gel::address_t& a);
+	bool visit(gel::address_t a);
+	bool add(Inst *inst, gel::address_t a, t::uint32 size, Inst::kind_t kind,
+		bool branch = false, gel::address_t target = 0);
+	void addTarget(gel::address_t a, gel::address_t target);
+	void guess(const Vector<gel::address_t>& candidates);
+	void build();
+
+	// access
+	inline int count() const { return _blocks.count(); }
+	inline const Block& operator[](int i) const { return _blocks[i]; }
+	inline Inst *inst(const Block& b, int i) const { return _insts[b._first + i]; }
+	inline const Edge& edge(const Block& b, int i) const { return _edges[b._edge + i]; }
+	inline int edgeCount() const { return _edges.count(); }
+	inline int instCount() const { return _insts.count(); }
+	const Block *find(gel::address_t a) const;
+	t::uint32 indexOf(gel::address_t a) const;
+
+private:
+
+	typedef struct rec_t {
+		gel::address_t addr, target;
+		t::uint32 size;
+		Inst::kind_t kind;
+		bool branch;
+		Inst *inst;
+	} rec_t;
+
+	typedef struct target_t {
+		gel::address_t addr, target;
+	} target_t;
+
+	const SegmentIndex& _segs;
+	Vector<t::uint32 *> _marks;
+	Vector<gel::address_t> _todo, _leaders, _entries;
+	Vector<rec_t> _recs;
+	Vector<target_t> _targets;
+	Vector<Inst *> _insts;
+	Vector<Block> _blocks;
+	Vector<Edge> _edges;
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_BLOCK_TABLE_H
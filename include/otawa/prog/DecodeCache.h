@@ -0,0 +1,89 @@
+/*
+ *	DecodeCache class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_DECODE_CACHE_H
+#define OTAWA_PROG_DECODE_CACHE_H
+
+#include <cstdio>
+#include <elm/types.h>
+#include <elm/data/Vector.h>
+#include <gel++.h>
+
+namespace otawa {
+
+using namespace elm;
+class FileMap;
+
+class DecodeCache {
+public:
+	static const t::uint32 FORMAT_VERSION = 2;
+	static const int ID_SIZE = 48;
+
+	static t::uint64 hash(const t::uint8 *data, t::size size);
+
+	class Writer {
+	public:
+		Writer(cstring path, cstring id, t::uint64 hash);
+		~Writer();
+		inline bool isOpen() const { return _file != nullptr; }
+		void beginSection(gel::address_t base, t::uint32 rows, t::uint32 columns);
+		void column(const void *data, t::uint64 size);
+		bool close();
+	private:
+		void write(const void *data, t::uint64 size);
+		string _path, _tmp;
+		FILE *_file;
+		t::uint32 _sections;
+		bool _failed;
+	};
+
+	class Section {
+		friend class DecodeCache;
+	public:
+		inline gel::address_t base() const { return _base; }
+		inline t::uint32 rows() const { return _rows; }
+		inline int columns() const { return _cols.count(); }
+		inline const void *column(int i) const { return _cols[i]; }
+		inline t::uint64 columnSize(int i) const { return _sizes[i]; }
+	private:
+		gel::address_t _base;
+		t::uint32 _rows;
+		Vector<const void *> _cols;
+		Vector<t::uint64> _sizes;
+	};
+
+	class Reader {
+	public:
+		Reader(cstring path, cstring id, t::uint64 hash);
+		~Reader();
+		inline bool isValid() const { return _valid; }
+		inline int count() const { return _sections.count(); }
+		inline const Section& operator[](int i) const { return *_sections[i]; }
+	private:
+		bool parse(cstring id, t::uint64 hash);
+		FileMap *_map;
+		Vector<Section *> _sections;
+		bool _valid;
+	};
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_DECODE_CACHE_H
@@ -22,32 +22,62 @@
 #define OTAWA_PROG_DECODER_H
 
 #include <elm/types.h>
+#include <elm/io.h>
+#include <elm/data/Vector.h>
 #include <elm/sys/Plugin.h>
 #include <otawa/base.h>
+#include <otawa/prop/PropList.h>
 #include <gel++.h>
+#include <otawa/prog/DecodeCache.h>
+#include <otawa/prog/SegmentIndex.h>
 
 namespace otawa {
 
 using namespace elm;
+class BlockTable;
 class Inst;
 namespace hard { class Platform; }
 	
 class Decoder {
 public:
+
+	class Sink {
+	public:
+		virtual ~Sink();
+		virtual void put(Inst *inst) = 0;
+	};
+
 	Decoder(gel::Image *image);
 	virtual ~Decoder();
 	inline gel::Image *image() const { return _image; }
+	inline const SegmentIndex& segments()
+		{ if(_segs == nullptr) useSegments(nullptr); return *_segs; }
+	void useSegments(const SegmentIndex *index);
 	virtual Inst *decode(gel::address_t a) = 0;
+	virtual void decodeRange(gel::address_t start, gel::address_t end, Sink& sink);
+	virtual void predecode(gel::address_t start, gel::address_t end,
+		const Vector<gel::address_t>& starts, int threads);
+	virtual void discover(const Vector<gel::address_t>& entries, BlockTable& table);
 	virtual t::size instSize() const = 0;
 	virtual hard::Platform *platform() const = 0;
+	virtual t::size footprint() const;
+	virtual t::uint64 cacheHits() const;
+	virtual t::uint64 cacheMisses() const;
+	virtual string cacheId() const;
+	virtual void saveCache(DecodeCache::Writer& writer);
+	virtual bool loadCache(const DecodeCache::Reader& reader);
+	virtual bool dumpStats(io::Output& out);
 private:
 	gel::Image *_image;
+	const SegmentIndex *_segs;
+	bool _own;
 };
 
 class DecoderPlugin: public sys::Plugin {
 public:	
 	DecoderPlugin(string name, const Version& plugger_version, CString hook);
 	virtual Decoder *decode(gel::Image *image) = 0;
+	virtual Decoder *decode(gel::Image *image, const PropList& props);
 };
 
 #define OTAWA_DECODER_VERSION	"1.0.0"
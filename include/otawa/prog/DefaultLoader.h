@@ -27,6 +27,31 @@ namespace otawa {
 
 using namespace elm;
 
+extern Identifier<bool> PREDECODE;
+extern Identifier<int> PREDECODE_THREADS;
+extern Identifier<string> DECODER_ENGINE;
+extern Identifier<int> ELF_MACHINE;
+extern Identifier<bool> LAZY_SYMBOLS;
+extern Identifier<string> DECODE_CACHE;
+extern Identifier<bool> DISCOVER;
+extern Identifier<string> DECODE_STATS;
+extern Identifier<bool> DECODE_LAZY;
+extern Identifier<string> LOAD_TRACE;
+class BlockTable;
+extern Identifier<BlockTable *> BLOCK_TABLE;
+class SegmentIndex;
+extern Identifier<SegmentIndex *> SEGMENT_INDEX;
+class SymbolIndex;
+extern Identifier<SymbolIndex *> SYMBOL_INDEX;
+
+class LoadObserver {
+public:
+	virtual ~LoadObserver();
+	virtual void beginPhase(cstring name) = 0;
+	virtual void endPhase(cstring name) = 0;
+};
+extern Identifier<LoadObserver *> LOAD_OBSERVER;
+
 class DefaultLoader: public Loader {
 public:
 	DefaultLoader(
@@ -0,0 +1,75 @@
+/*
+ *	InstCache class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_INST_CACHE_H
+#define OTAWA_PROG_INST_CACHE_H
+
+#include <elm/types.h>
+#include <gel++.h>
+
+namespace otawa {
+
+using namespace elm;
+class Inst;
+
+class InstCache {
+public:
+	static const int PAGE_BITS = 12;
+	static const t::uint32 PAGE_SIZE = 1 << PAGE_BITS;
+
+	InstCache(gel::address_t base, t::uint32 size);
+	~InstCache();
+
+	inline Inst *get(gel::address_t a) const {
+		t::uint32 o = a - _base;
+		auto p = _pages[o >> PAGE_BITS];
+		return p == nullptr ? nullptr : p[o & (PAGE_SIZE - 1)];
+	}
+
+	inline Inst *find(gel::address_t a) {
+		auto i = get(a);
+		if(i != nullptr)
+			_hits++;
+		else
+			_misses++;
+		return i;
+	}
+
+	inline void put(gel::address_t a, Inst *inst) {
+		t::uint32 o = a - _base;
+		auto& p = _pages[o >> PAGE_BITS];
+		if(p == nullptr)
+			p = new Inst *[PAGE_SIZE]();
+		p[o & (PAGE_SIZE - 1)] = inst;
+	}
+
+	inline t::uint64 hits() const { return _hits; }
+	inline t::uint64 misses() const { return _misses; }
+
+private:
+	gel::address_t _base;
+	t::uint32 _count;
+	Inst ***_pages;
+	t::uint64 _hits, _misses;
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_INST_CACHE_H
@@ -0,0 +1,49 @@
+/*
+ *	JumpTable class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_JUMP_TABLE_H
+#define OTAWA_PROG_JUMP_TABLE_H
+
+#include <elm/types.h>
+#include <elm/data/Vector.h>
+#include <gel++.h>
+#include <otawa/prop/Identifier.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class JumpTable {
+public:
+	JumpTable(gel::address_t address, const Vector<gel::address_t>& targets);
+	inline gel::address_t address() const { return _address; }
+	inline int count() const { return _targets.count(); }
+	inline gel::address_t operator[](int i) const { return _targets[i]; }
+	inline const Vector<gel::address_t>& targets() const { return _targets; }
+private:
+	gel::address_t _address;
+	Vector<gel::address_t> _targets;
+};
+
+extern Identifier<JumpTable *> JUMP_TABLE;
+
+}	// otawa
+
+#endif	// OTAWA_PROG_JUMP_TABLE_H
@@ -0,0 +1,52 @@
+/*
+ *	RegMask class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_REG_MASK_H
+#define OTAWA_PROG_REG_MASK_H
+
+#include <elm/types.h>
+#include <otawa/prog/Inst.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class RegMask {
+public:
+	typedef t::uint64 mask_t;
+	static const int MAX = 64;
+
+	virtual ~RegMask();
+	virtual mask_t readMask() const = 0;
+	virtual mask_t writeMask() const = 0;
+
+	static inline RegMask *of(Inst *inst) { return dynamic_cast<RegMask *>(inst); }
+
+	static inline void fill(mask_t mask, RegSet& set) {
+		while(mask != 0) {
+			set.add(__builtin_ctzll(mask));
+			mask &= mask - 1;
+		}
+	}
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_REG_MASK_H
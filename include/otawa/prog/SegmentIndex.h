@@ -0,0 +1,116 @@
+/*
+ *	SegmentIndex class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_SEGMENT_INDEX_H
+#define OTAWA_PROG_SEGMENT_INDEX_H
+
+#include <cstring>
+#include <elm/types.h>
+#include <gel++.h>
+#include <gel++/Image.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class SegmentIndex {
+public:
+
+	class Entry {
+		friend class SegmentIndex;
+	public:
+		inline gel::address_t base() const { return _base; }
+		inline gel::address_t top() const { return _top; }
+		inline t::uint32 size() const { return _top - _base; }
+		inline gel::ImageSegment *segment() const { return _seg; }
+		inline int index() const { return _index; }
+		inline bool contains(gel::address_t a) const { return _base <= a && a < _top; }
+		inline const t::uint8 *bytes() const { return _seg->buffer().at(0); }
+		inline t::uint32 available() const
+			{ return _seg->hasContent() ? _seg->buffer().size() : 0; }
+
+		template <class T>
+		void read(gel::address_t a, T *buf, int count) const {
+			t::uint32 o = a - _base, n = count * sizeof(T), av = available();
+			t::uint32 m = o >= av ? 0 : av - o < n ? av - o : n;
+			if(m != 0)
+				memcpy(buf, bytes() + o, m);
+			if(m < n)
+				memset(reinterpret_cast<t::uint8 *>(buf) + m, 0, n - m);
+#			if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+				if(sizeof(T) > 1)
+					for(int i = 0; i < count; i++)
+						swap(buf[i]);
+#			endif
+		}
+
+		int stringLength(gel::address_t a) const;
+
+	private:
+		template <class T>
+		static inline void swap(T& v) {
+			t::uint8 *p = reinterpret_cast<t::uint8 *>(&v);
+			for(int i = 0, j = sizeof(T) - 1; i < j; i++, j--) {
+				t::uint8 x = p[i];
+				p[i] = p[j];
+				p[j] = x;
+			}
+		}
+
+		gel::address_t _base, _top;
+		gel::ImageSegment *_seg;
+		int _index;
+	};
+
+	SegmentIndex(gel::Image *image);
+	~SegmentIndex();
+
+	inline int count() const { return _count; }
+	inline const Entry& operator[](int i) const { return _entries[i]; }
+
+	inline const Entry *at(gel::address_t a) const {
+		if(_last != nullptr && _last->contains(a))
+			return _last;
+		auto e = lookup(a);
+		if(e != nullptr)
+			_last = e;
+		return e;
+	}
+
+	const Entry *lookup(gel::address_t a) const;
+
+	template <class T>
+	inline bool read(gel::address_t a, T *buf, int count = 1) const {
+		auto e = at(a);
+		if(e == nullptr || t::uint64(a) + count * sizeof(T) > e->top())
+			return false;
+		e->read(a, buf, count);
+		return true;
+	}
+
+private:
+	Entry *_entries;
+	int _count;
+	mutable const Entry *_last;
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_SEGMENT_INDEX_H
@@ -0,0 +1,102 @@
+/*
+ *	SymbolIndex class interface
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef OTAWA_PROG_SYMBOL_INDEX_H
+#define OTAWA_PROG_SYMBOL_INDEX_H
+
+#include <elm/types.h>
+#include <elm/data/Vector.h>
+#include <gel++.h>
+#include <otawa/prog/File.h>
+#include <otawa/prog/Symbol.h>
+
+namespace otawa {
+
+using namespace elm;
+
+class SymbolIndex {
+public:
+
+	class Entry {
+		friend class SymbolIndex;
+	public:
+		inline gel::address_t address() const { return _base; }
+		inline gel::address_t top() const { return _top; }
+		inline t::uint32 size() const { return _top - _base; }
+		inline Symbol::kind_t kind() const { return _kind; }
+		inline cstring name() const { return _gsym->name(); }
+		inline File *file() const { return _file; }
+		inline bool contains(gel::address_t a) const
+			{ return a == _base || (_base <= a && a < _top); }
+	private:
+		gel::address_t _base, _top;
+		Symbol::kind_t _kind;
+		gel::Symbol *_gsym;
+		File *_file;
+		mutable Symbol *_sym;
+	};
+
+	SymbolIndex();
+	~SymbolIndex();
+
+	void add(File *file, gel::Symbol *sym);
+	void build();
+
+	inline int count() const { return _entries.count(); }
+	inline const Entry& operator[](int i) const { return _entries[i]; }
+	inline const Entry *function(gel::address_t a) const { return _funs.lookup(a); }
+	inline const Entry *data(gel::address_t a) const { return _data.lookup(a); }
+	const Entry *find(cstring name) const;
+
+	Symbol *symbol(const Entry& e) const;
+	void materializeAll() const;
+	inline bool isMaterialized() const { return _all; }
+
+private:
+
+	class Table {
+	public:
+		Table();
+		~Table();
+		void build(const Vector<Entry *>& sorted);
+		const Entry *lookup(gel::address_t a) const;
+	private:
+		int fill(int i, int k);
+
+		typedef struct node_t {
+			gel::address_t key;
+			t::uint32 rank;
+		} node_t;
+
+		int _n;
+		node_t *_nodes;
+		Entry **_sorted;
+		t::uint32 *_cover;
+	};
+
+	Vector<Entry> _entries;
+	Table _funs, _data;
+	mutable Vector<const Entry *> _names;
+	mutable bool _all;
+};
+
+}	// otawa
+
+#endif	// OTAWA_PROG_SYMBOL_INDEX_H
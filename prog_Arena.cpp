@@ -0,0 +1,103 @@
+/*
+ *	Arena class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <otawa/prog/Arena.h>
+
+namespace otawa {
+
+/**
+ * @class Arena
+ * Bump allocator for objects that live as long as their owner, typically
+ * the instructions produced by a decoder. Memory is obtained by big
+ * blocks, allocation only moves a pointer in the current block and
+ * the whole memory is released at once when the arena is cleared or
+ * destroyed: objects allocated in an arena are never freed individually.
+ *
+ * @ingroup prog
+ */
+
+/**
+ * Build an arena.
+ * @param block_size	Size of the blocks obtained from the system.
+ */
+Arena::Arena(t::size block_size)
+	: _bsize(block_size), _blocks(nullptr), _top(nullptr), _end(nullptr), _reserved(0), _used(0) { }
+
+///
+Arena::~Arena() {
+	clear();
+}
+
+/**
+ * @fn void *Arena::allocate(t::size size, t::size align);
+ * Allocate memory in the arena.
+ * @param size		Size of the allocated memory (in bytes).
+ * @param align		Alignment of the memory (power of 2).
+ * @return			Allocated memory.
+ */
+
+/**
+ * Release all the memory of the arena.
+ */
+void Arena::clear() {
+	while(_blocks != nullptr) {
+		auto b = _blocks;
+		_blocks = b->next;
+		delete [] reinterpret_cast<char *>(b);
+	}
+	_top = nullptr;
+	_end = nullptr;
+	_reserved = 0;
+	_used = 0;
+}
+
+/**
+ * @fn t::size Arena::footprint() const;
+ * Get the memory reserved by the arena.
+ * @return	Reserved memory (in bytes).
+ */
+
+/**
+ * @fn t::size Arena::used() const;
+ * Get the memory actually allocated in the arena.
+ * @return	Allocated memory (in bytes).
+ */
+
+/**
+ * Allocate a new block and the memory in it.
+ * @param size		Size of the allocated memory (in bytes).
+ * @param align		Alignment of the memory (power of 2).
+ * @return			Allocated memory.
+ */
+void *Arena::allocateBlock(t::size size, t::size align) {
+	t::size s = sizeof(block_t) + size + align;
+	if(s < _bsize)
+		s = _bsize;
+	auto b = reinterpret_cast<block_t *>(new char[s]);
+	b->next = _blocks;
+	_blocks = b;
+	_reserved += s;
+	_top = reinterpret_cast<char *>(b + 1);
+	_end = reinterpret_cast<char *>(b) + s;
+	return allocate(size, align);
+}
+
+}	// otawa
@@ -0,0 +1,362 @@
+/*
+ *	BlockTable class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <otawa/prog/BlockTable.h>
+
+namespace otawa {
+
+// test if the execution may continue after an instruction of the given kind
+static inline bool falls(Inst::kind_t kind) {
+	if(!(kind & Inst::IS_CONTROL))
+		return true;
+	if(kind & Inst::IS_RETURN)
+		return false;
+	return (kind & (Inst::IS_COND | Inst::IS_CALL | Inst::IS_TRAP)) != 0;
+}
+
+// sort and remove duplicates
+static void normalize(Vector<gel::address_t>& v) {
+	if(v.count() == 0)
+		return;
+	auto p = &v[0];
+	std::sort(p, p + v.count());
+	int n = std::unique(p, p + v.count()) - p;
+	while(v.count() > n)
+		v.pop();
+}
+
+/**
+ * @class BlockTable
+ * Table of the basic blocks of a program found by recursive-descent
+ * discovery (see Decoder::discover()). The discovery follows, from the
+ * entry points, the direct branches, the calls and the fall-throughs
+ * and records the reached instructions and the branch targets (leaders).
+ * build() then produces the blocks and their edges in one pass over the
+ * instructions sorted by address.
+ *
+ * Blocks are sorted by address and designated by their index. Each block
+ * keeps its instructions, that are owned by the decoder, so that no
+ * decoding is needed to build the CFG. The edges of a block are
+ * its fall-through (FALL), its direct branch (TAKEN) or its direct
+ * call (CALL). Indirect branches have no edge, and can be identified
+ * by the kind of the block, unless the decoder has resolved their
+ * targets (see addTarget()).
+ *
+ * @ingroup prog
+ */
+
+/**
+ * @class BlockTable::Edge
+ * Edge between two blocks of a BlockTable.
+ */
+
+/**
+ * @fn t::uint32 BlockTable::Edge::target() const;
+ * Get the index of the target block.
+ * @return	Target block index or NO_BLOCK if the target has not been
+ * 			decoded (outside of the executable segments, undecodable).
+ */
+
+/**
+ * @class BlockTable::Block
+ * Basic block of a BlockTable.
+ */
+
+/**
+ * @fn Inst::kind_t BlockTable::Block::kind() const;
+ * Get the kind of the instruction ending the block. Only the control
+ * flags of the kind are guaranteed to be set.
+ * @return	Kind of the last instruction.
+ */
+
+/**
+ * @fn bool BlockTable::Block::isEntry() const;
+ * Test if the block is an entry point of the program or a sub-program
+ * entry (function symbol, call target, etc).
+ * @return	True if the block is an entry, false else.
+ */
+
+/**
+ * Build an empty block table.
+ * @param segments	Segments of the program.
+ */
+BlockTable::BlockTable(const SegmentIndex& segments): _segs(segments) {
+}
+
+///
+BlockTable::~BlockTable() {
+	for(auto m: _marks)
+		delete [] m;
+}
+
+/**
+ * Add an entry point to explore.
+ * @param a		Entry address.
+ */
+void BlockTable::entry(gel::address_t a) {
+	_entries.add(a);
+	_leaders.add(a);
+	_todo.add(a);
+}
+
+/**
+ * Get the next address to explore.
+ * @param a		Set to the next address.
+ * @return		True if there is an address to explore, false if the
+ * 				discovery is over.
+ */
+bool BlockTable::next(gel::address_t& a) {
+	if(_todo.count() == 0)
+		return false;
+	a = _todo.pop();
+	return true;
+}
+
+/**
+ * Mark an instruction start as visited.
+ * @param a		Instruction address.
+ * @return		True if the address is in an executable segment and has
+ * 				not been visited yet, false else.
+ */
+bool BlockTable::visit(gel::address_t a) {
+	auto e = _segs.at(a);
+	if(e == nullptr || !e->segment()->isExecutable())
+		return false;
+	while(_marks.count() <= e->index())
+		_marks.add(nullptr);
+	auto& m = _marks[e->index()];
+	if(m == nullptr) {
+		int n = (e->size() + 31) / 32;
+		m = new t::uint32[n];
+		memset(m, 0, n * sizeof(t::uint32));
+	}
+	t::uint32 o = a - e->base(), b = 1 << (o & 31);
+	if(m[o >> 5] & b)
+		return false;
+	m[o >> 5] |= b;
+	return true;
+}
+
+/**
+ * Record a reached instruction. The branch target, if any, is added to
+ * the addresses to explore.
+ * @param inst		Instruction (owned by the decoder).
+ * @param a			Instruction address.
+ * @param size		Instruction size.
+ * @param kind		Instruction kind (at least its control flags).
+ * @param branch	True if the instruction has a direct branch target.
+ * @param target	Branch target address (if branch is true).
+ * @return			True if the execution may continue with the next
+ * 					instruction, false else.
+ */
+bool BlockTable::add(Inst *inst, gel::address_t a, t::uint32 size, Inst::kind_t kind, bool branch, gel::address_t target) {
+	_recs.add({ a, target, size, kind, branch, inst });
+	if(branch) {
+		if(kind & Inst::IS_CALL)
+			entry(target);
+		else {
+			_leaders.add(target);
+			_todo.add(target);
+		}
+	}
+	return falls(kind);
+}
+
+/**
+ * Record a target of an indirect branch resolved by the decoder (for example
+ * from a jump table). The target is added to the addresses to explore and
+ * produces a TAKEN edge from the block ending with the branch.
+ * @param a			Branch instruction address.
+ * @param target	Target address.
+ */
+void BlockTable::addTarget(gel::address_t a, gel::address_t target) {
+	_targets.add({ a, target });
+	_leaders.add(target);
+	_todo.add(target);
+}
+
+/**
+ * Add as entry points the candidate addresses (for example found by
+ * pattern matching in a stripped program) that are not inside an already
+ * recorded instruction. This is used to fill the gaps left by a first
+ * discovery pass without splitting the found instructions.
+ * @param candidates	Candidate entry addresses.
+ */
+void BlockTable::guess(const Vector<gel::address_t>& candidates) {
+	if(_recs.count() != 0)
+		std::sort(&_recs[0], &_recs[0] + _recs.count(),
+			[](const rec_t& r1, const rec_t& r2) { return r1.addr < r2.addr; });
+	for(auto a: candidates) {
+		int l = 0, h = _recs.count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(_recs[m].addr <= a)
+				l = m + 1;
+			else
+				h = m;
+		}
+		if(l == 0 || a >= _recs[l - 1].addr + _recs[l - 1].size)
+			entry(a);
+	}
+}
+
+/**
+ * Build the blocks and the edges from the recorded instructions. The
+ * discovery data are released.
+ */
+void BlockTable::build() {
+	normalize(_leaders);
+	normalize(_entries);
+	if(_recs.count() != 0)
+		std::sort(&_recs[0], &_recs[0] + _recs.count(),
+			[](const rec_t& r1, const rec_t& r2) { return r1.addr < r2.addr; });
+	if(_targets.count() != 0)
+		std::stable_sort(&_targets[0], &_targets[0] + _targets.count(),
+			[](const target_t& t1, const target_t& t2) { return t1.addr < t2.addr; });
+
+	// cut the blocks
+	int l = 0, e = 0;
+	for(int i = 0; i < _recs.count(); i++) {
+		const rec_t& r = _recs[i];
+		while(l < _leaders.count() && _leaders[l] < r.addr)
+			l++;
+		if(i == 0
+		|| _recs[i - 1].addr + _recs[i - 1].size != r.addr
+		|| (_recs[i - 1].kind & Inst::IS_CONTROL)
+		|| (l < _leaders.count() && _leaders[l] == r.addr)) {
+			while(e < _entries.count() && _entries[e] < r.addr)
+				e++;
+			Block b;
+			b._base = r.addr;
+			b._first = i;
+			b._count = 0;
+			b._edge = b._ecount = 0;
+			b._entry = e < _entries.count() && _entries[e] == r.addr;
+			_blocks.add(b);
+		}
+		Block& b = _blocks[_blocks.count() - 1];
+		b._top = r.addr + r.size;
+		b._kind = r.kind;
+		b._count++;
+		_insts.add(r.inst);
+	}
+
+	// link the blocks
+	int k = 0;
+	for(int i = 0; i < _blocks.count(); i++) {
+		Block& b = _blocks[i];
+		const rec_t& r = _recs[b._first + b._count - 1];
+		b._edge = _edges.count();
+		if(r.branch) {
+			Edge e;
+			e._source = i;
+			e._target = indexOf(r.target);
+			e._kind = r.kind & Inst::IS_CALL ? CALL : TAKEN;
+			_edges.add(e);
+		}
+		while(k < _targets.count() && _targets[k].addr < r.addr)
+			k++;
+		for(; k < _targets.count() && _targets[k].addr == r.addr; k++) {
+			Edge e;
+			e._source = i;
+			e._target = indexOf(_targets[k].target);
+			e._kind = TAKEN;
+			_edges.add(e);
+		}
+		if(falls(r.kind)) {
+			Edge e;
+			e._source = i;
+			e._target = indexOf(b._top);
+			e._kind = FALL;
+			_edges.add(e);
+		}
+		b._ecount = _edges.count() - b._edge;
+	}
+
+	// release discovery data
+	_recs.clear();
+	_targets.clear();
+	_leaders.clear();
+	_entries.clear();
+	_todo.clear();
+	for(auto& m: _marks) {
+		delete [] m;
+		m = nullptr;
+	}
+}
+
+/**
+ * @fn Inst *BlockTable::inst(const Block& b, int i) const;
+ * Get an instruction of a block.
+ * @param b		Block.
+ * @param i		Instruction index in the block.
+ * @return		Matching instruction.
+ */
+
+/**
+ * @fn const Edge& BlockTable::edge(const Block& b, int i) const;
+ * Get an edge leaving a block.
+ * @param b		Source block.
+ * @param i		Edge index in the block.
+ * @return		Matching edge.
+ */
+
+/**
+ * Find the block containing the given address.
+ * @param a		Looked address.
+ * @return		Found block or null.
+ */
+const BlockTable::Block *BlockTable::find(gel::address_t a) const {
+	int l = 0, h = _blocks.count();
+	while(l < h) {
+		int m = (l + h) / 2;
+		if(_blocks[m]._base <= a)
+			l = m + 1;
+		else
+			h = m;
+	}
+	if(l == 0 || !_blocks[l - 1].contains(a))
+		return nullptr;
+	return &_blocks[l - 1];
+}
+
+/**
+ * Get the index of the block starting at the given address.
+ * @param a		Block address.
+ * @return		Block index or NO_BLOCK.
+ */
+t::uint32 BlockTable::indexOf(gel::address_t a) const {
+	int l = 0, h = _blocks.count();
+	while(l < h) {
+		int m = (l + h) / 2;
+		if(_blocks[m]._base < a)
+			l = m + 1;
+		else
+			h = m;
+	}
+	if(l < _blocks.count() && _blocks[l]._base == a)
+		return l;
+	return NO_BLOCK;
+}
+
+}	// otawa
@@ -0,0 +1,288 @@
+/*
+ *	DecodeCache class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <unistd.h>
+
+#include <otawa/base.h>
+#include <otawa/prog/DecodeCache.h>
+#include <otawa/prog/FileMap.h>
+
+namespace otawa {
+
+// file layout
+static const char MAGIC[8] = { 'O', 'T', 'A', 'W', 'A', 'D', 'C', '\0' };
+
+typedef struct header_t {
+	char magic[8];
+	t::uint32 version;
+	t::uint32 sections;
+	t::uint64 hash;
+	char id[DecodeCache::ID_SIZE];
+} header_t;
+
+typedef struct section_t {
+	t::uint64 base;
+	t::uint32 rows;
+	t::uint32 columns;
+} section_t;
+
+static const t::uint64 ALIGN = 8;
+
+static inline t::uint64 padding(t::uint64 size)
+	{ return (ALIGN - size % ALIGN) % ALIGN; }
+
+/**
+ * @class DecodeCache
+ * On-disk cache of decoded instructions. A cache file is bound to the
+ * content of an executable (by its hash) and to the decoder that produced
+ * it (by an identifier including its version). It is made of sections,
+ * one by decoded segment, each one holding a set of columns, that is,
+ * arrays of rows defined by the decoder.
+ *
+ * All data are 8-bytes aligned in the file so that the columns can be read
+ * in place in a read-only mapping of the file. The mapping only lives as
+ * long as the reader: a decoder loading a cache copies the rows into its
+ * own storage. Data are stored in the host byte order: a file produced on
+ * a host with a different byte order is rejected as its format version
+ * does not match.
+ *
+ * @ingroup prog
+ */
+
+/**
+ * Compute the hash (64-bits FNV-1a) of the given data.
+ * @param data	Data to hash.
+ * @param size	Data size (in bytes).
+ * @return		Data hash.
+ */
+t::uint64 DecodeCache::hash(const t::uint8 *data, t::size size) {
+	t::uint64 h = 0xcbf29ce484222325ULL;
+	for(t::size i = 0; i < size; i++) {
+		h ^= data[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+
+/**
+ * @class DecodeCache::Writer
+ * Writer of a cache file. The file is written under a temporary name and
+ * renamed when it is closed so that concurrent readers never see a partial
+ * cache file.
+ */
+
+/**
+ * Open a cache file for writing.
+ * @param path	Cache file path.
+ * @param id	Decoder identifier.
+ * @param hash	Executable hash.
+ */
+DecodeCache::Writer::Writer(cstring path, cstring id, t::uint64 hash)
+: _path(path), _file(nullptr), _sections(0), _failed(false) {
+	_tmp = _ << path << ".tmp." << getpid();
+	_file = fopen(_tmp.toCString().chars(), "wb");
+	if(_file == nullptr)
+		return;
+	header_t h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = FORMAT_VERSION;
+	h.hash = hash;
+	strncpy(h.id, id.chars(), ID_SIZE - 1);
+	write(&h, sizeof(h));
+}
+
+///
+DecodeCache::Writer::~Writer() {
+	if(_file != nullptr) {
+		fclose(_file);
+		unlink(_tmp.toCString().chars());
+	}
+}
+
+/**
+ * @fn bool DecodeCache::Writer::isOpen() const;
+ * Test if the cache file has been successfully opened.
+ * @return	True if the file is open, false else.
+ */
+
+/**
+ * Start a new section. It must be followed by exactly the given number
+ * of columns.
+ * @param base		Base address of the section.
+ * @param rows		Number of rows.
+ * @param columns	Number of columns.
+ */
+void DecodeCache::Writer::beginSection(gel::address_t base, t::uint32 rows, t::uint32 columns) {
+	section_t s = { t::uint64(base), rows, columns };
+	write(&s, sizeof(s));
+	_sections++;
+}
+
+/**
+ * Add a column to the current section.
+ * @param data	Column data.
+ * @param size	Column size (in bytes).
+ */
+void DecodeCache::Writer::column(const void *data, t::uint64 size) {
+	static const t::uint8 zeros[ALIGN] = { 0 };
+	write(&size, sizeof(size));
+	write(data, size);
+	write(zeros, padding(size));
+}
+
+/**
+ * Close the file and make it visible under its final name.
+ * @return	True if the file has been successfully written, false else.
+ */
+bool DecodeCache::Writer::close() {
+	if(_file == nullptr)
+		return false;
+	if(!_failed) {
+		_failed = fseek(_file, offsetof(header_t, sections), SEEK_SET) != 0;
+		write(&_sections, sizeof(_sections));
+	}
+	_failed = fclose(_file) != 0 || _failed;
+	_file = nullptr;
+	if(!_failed)
+		_failed = rename(_tmp.toCString().chars(), _path.toCString().chars()) != 0;
+	if(_failed)
+		unlink(_tmp.toCString().chars());
+	return !_failed;
+}
+
+void DecodeCache::Writer::write(const void *data, t::uint64 size) {
+	if(!_failed && size != 0)
+		_failed = fwrite(data, 1, size, _file) != size;
+}
+
+
+/**
+ * @class DecodeCache::Section
+ * Section of a cache file read by DecodeCache::Reader.
+ */
+
+/**
+ * @fn const void *DecodeCache::Section::column(int i) const;
+ * Get the data of a column, 8-bytes aligned, in the file mapping
+ * (only valid as long as the reader exists).
+ * @param i		Column index.
+ * @return		Column data.
+ */
+
+
+/**
+ * @class DecodeCache::Reader
+ * Reader of a cache file. The file is mapped in memory and the columns
+ * are read in place in the mapping, that is released with the reader.
+ */
+
+/**
+ * Open a cache file for reading. The cache is valid only if it exists,
+ * it is well-formed and it matches the given decoder and hash.
+ * @param path	Cache file path.
+ * @param id	Decoder identifier.
+ * @param hash	Executable hash.
+ */
+DecodeCache::Reader::Reader(cstring path, cstring id, t::uint64 hash): _map(nullptr), _valid(false) {
+	if(access(path.chars(), R_OK) != 0)
+		return;
+	try {
+		_map = new FileMap(path);
+	}
+	catch(otawa::Exception& e) {
+		return;
+	}
+	_valid = parse(id, hash);
+}
+
+///
+DecodeCache::Reader::~Reader() {
+	for(auto s: _sections)
+		delete s;
+	if(_map != nullptr)
+		delete _map;
+}
+
+bool DecodeCache::Reader::parse(cstring id, t::uint64 hash) {
+	const t::uint8 *p = _map->data(), *e = p + _map->size();
+
+	// check header
+	if(e - p < t::intptr(sizeof(header_t)))
+		return false;
+	auto h = reinterpret_cast<const header_t *>(p);
+	char hid[ID_SIZE] = { 0 };
+	strncpy(hid, id.chars(), ID_SIZE - 1);
+	if(memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0
+	|| h->version != FORMAT_VERSION
+	|| h->hash != hash
+	|| memcmp(h->id, hid, ID_SIZE) != 0)
+		return false;
+	p += sizeof(header_t);
+
+	// read sections
+	for(t::uint32 i = 0; i < h->sections; i++) {
+		if(e - p < t::intptr(sizeof(section_t)))
+			return false;
+		auto sh = reinterpret_cast<const section_t *>(p);
+		p += sizeof(section_t);
+		auto s = new Section();
+		_sections.add(s);
+		s->_base = sh->base;
+		s->_rows = sh->rows;
+		for(t::uint32 j = 0; j < sh->columns; j++) {
+			if(e - p < t::intptr(sizeof(t::uint64)))
+				return false;
+			t::uint64 size = *reinterpret_cast<const t::uint64 *>(p);
+			p += sizeof(t::uint64);
+			if(t::uint64(e - p) < size + padding(size))
+				return false;
+			s->_cols.add(p);
+			s->_sizes.add(size);
+			p += size + padding(size);
+		}
+	}
+	return true;
+}
+
+/**
+ * @fn bool DecodeCache::Reader::isValid() const;
+ * Test if the cache file is valid.
+ * @return	True if the cache is valid, false else.
+ */
+
+/**
+ * @fn int DecodeCache::Reader::count() const;
+ * Get the number of sections.
+ * @return	Section count.
+ */
+
+/**
+ * @fn const Section& DecodeCache::Reader::operator[](int i) const;
+ * Get a section.
+ * @param i		Section index.
+ * @return		Matching section.
+ */
+
+}	// otawa
@@ -19,7 +19,9 @@
  *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <otawa/prog/BlockTable.h>
 #include <otawa/prog/Decoder.h>
+#include <otawa/prog/Inst.h>
 
 namespace otawa {
 
@@ -30,23 +32,147 @@ namespace otawa {
  * @ingroup prog
  */
 
+/**
+ * @class Decoder::Sink
+ * Receiver of instructions produced by Decoder::decodeRange().
+ */
+
+///
+Decoder::Sink::~Sink() { }
+
+/**
+ * @fn void Decoder::Sink::put(Inst *inst);
+ * Called for each decoded instruction.
+ * @param inst	Decoded instruction (owned by the decoder).
+ */
+
 /**
  * Build a decoder on the given image.
  * @param image		Image used by the decoder.
  */
-Decoder::Decoder(gel::Image *image): _image(image) {
+Decoder::Decoder(gel::Image *image): _image(image), _segs(nullptr), _own(false) {
 }
 
 ///
-Decoder::~Decoder() { }
+Decoder::~Decoder() {
+	if(_own)
+		delete _segs;
+}
+
+/**
+ * @fn const SegmentIndex& Decoder::segments();
+ * Get the segment index used to locate the segments of the image.
+ * If none has been provided with useSegments(), the decoder builds its own.
+ * @return	Segment index.
+ */
+
+/**
+ * Set the segment index to use. This lets the decoder share the index
+ * built by the process instead of building its own.
+ * @param index		Segment index to use (ownership kept by the caller)
+ * 					or null to let the decoder build its own index.
+ */
+void Decoder::useSegments(const SegmentIndex *index) {
+	if(_own)
+		delete _segs;
+	if(index != nullptr) {
+		_segs = index;
+		_own = false;
+	}
+	else {
+		_segs = new SegmentIndex(_image);
+		_own = true;
+	}
+}
 
 
 /**
  * @fn Inst *Decoder::decode(gel::address_t a);
- * Decode the instruction at address a.
+ * Decode the instruction at address a. The instruction is owned by the
+ * decoder and released when the decoder is deleted. Decoders caching their
+ * instructions return the same instruction object for the same address.
  * @param a		Address of decoded instruction.
- * @return		Decode instruction (ownership passed to caller).
+ * @return		Decoded instruction (owned by the decoder) or null.
+ */
+
+/**
+ * Decode all instructions in the range [start, end[ and pass them,
+ * in address order, to the given sink. Decoding stops at the end of
+ * the range or as soon as an address cannot be decoded.
+ *
+ * The default implementation calls decode() for each instruction;
+ * decoders are expected to override it with a faster implementation
+ * working on the segment buffer.
+ *
+ * @param start		First address to decode.
+ * @param end		Address ending the range (excluded).
+ * @param sink		Sink receiving the decoded instructions (owned by the decoder).
+ */
+void Decoder::decodeRange(gel::address_t start, gel::address_t end, Sink& sink) {
+	gel::address_t a = start;
+	while(a < end) {
+		auto i = decode(a);
+		if(i == nullptr || i->size() == 0)
+			break;
+		sink.put(i);
+		a += i->size();
+	}
+}
+
+/**
+ * Decode in advance all instructions in the range [start, end[ so that
+ * later calls to decode() or decodeRange() are answered without decoding.
+ * The known instruction starts (symbols, entry point, etc) may be used
+ * by the decoder to split the range and decode the parts in parallel.
+ *
+ * The default implementation calls decodeRange() and drops the
+ * instructions: it is only useful for decoders caching their instructions.
+ *
+ * @param start		First address to decode.
+ * @param end		Address ending the range (excluded).
+ * @param starts	Known instruction starts, sorted by increasing address.
+ * @param threads	Maximum number of threads to use (0 for the number of cores).
+ */
+void Decoder::predecode(gel::address_t start, gel::address_t end,
+const Vector<gel::address_t>& starts, int threads) {
+
+	class NullSink: public Sink {
+	public:
+		void put(Inst *inst) override { }
+	} sink;
+
+	decodeRange(start, end, sink);
+}
+
+/**
+ * Discover the code reachable from the given entry points by recursive
+ * descent and record it in the given block table: direct branches, calls
+ * and fall-throughs are followed. The block table is built at the end
+ * (BlockTable::build()).
+ *
+ * The default implementation works on the instructions returned by decode()
+ * and is only suitable for decoders caching their instructions as the
+ * block table keeps them without owning them.
+ *
+ * @param entries	Entry points (program entry, function symbols, etc).
+ * @param table		Block table to fill.
  */
+void Decoder::discover(const Vector<gel::address_t>& entries, BlockTable& table) {
+	for(auto e: entries)
+		table.entry(e);
+	gel::address_t a;
+	while(table.next(a))
+		while(table.visit(a)) {
+			auto i = decode(a);
+			if(i == nullptr || i->size() == 0)
+				break;
+			auto t = i->target();
+			if(!table.add(i, a, i->size(), i->kind(), t != nullptr, t != nullptr ? t->address().offset() : 0))
+				break;
+			a += i->size();
+		}
+	table.build();
+}
 
 /**
  * @fn t::size Decoder::instSize() const;
@@ -56,10 +182,82 @@ Decoder::~Decoder() { }
 
 /**
  * @fn hard::Platform *Decoder::platform() const;
- * Get the platform used by the decoder.
+ * Get the platform used by the decoder. The platform is owned by the
+ * decoder plug-in and may be shared by several decoders and processes:
+ * it must not be modified or released by the caller.
  * @return	Decoder platform.
  */
 
+/**
+ * Get the memory used by the decoder to store the decoded instructions.
+ * The default implementation returns 0.
+ * @return	Used memory (in bytes).
+ */
+t::size Decoder::footprint() const {
+	return 0;
+}
+
+/**
+ * For decoders caching the decoded instructions, get the number of
+ * decode() calls answered by the cache. The default implementation
+ * returns 0.
+ * @return	Cache hit count.
+ */
+t::uint64 Decoder::cacheHits() const {
+	return 0;
+}
+
+/**
+ * For decoders caching the decoded instructions, get the number of
+ * instructions that had to be decoded. The default implementation
+ * returns 0.
+ * @return	Cache miss count.
+ */
+t::uint64 Decoder::cacheMisses() const {
+	return 0;
+}
+
+/**
+ * Get the identifier of the decoder in the decode caches (see DecodeCache).
+ * It must change each time the decoder or its cache layout changes.
+ * The default implementation returns an empty string meaning that the
+ * decoder does not support caching.
+ * @return	Cache identifier.
+ */
+string Decoder::cacheId() const {
+	return "";
+}
+
+/**
+ * Save the decoded instructions in the given cache writer. Only called
+ * for decoders supporting caching. The default implementation does nothing.
+ * @param writer	Writer to save to.
+ */
+void Decoder::saveCache(DecodeCache::Writer& writer) {
+}
+
+/**
+ * Restore the decoded instructions from the given cache. Only called just
+ * after the creation of the decoder. The default implementation does
+ * nothing and returns false.
+ * @param reader	Reader to restore from.
+ * @return			True if the cache has been used, false else.
+ */
+bool Decoder::loadCache(const DecodeCache::Reader& reader) {
+	return false;
+}
+
+/**
+ * Dump the statistics collected by the decoder as a JSON object. Only
+ * called for decoders built with the DECODE_STATS property set. The default
+ * implementation does nothing and returns false.
+ * @param out	Output stream.
+ * @return		True if statistics have been dumped, false else.
+ */
+bool Decoder::dumpStats(io::Output& out) {
+	return false;
+}
+
 
 /**
  * @class DecoderPlugin
@@ -77,5 +275,18 @@ DecoderPlugin::DecoderPlugin(string name, const Version& plugger_version, CStrin
  * @param image		Image to decode in.
  * @return			Decoder for the image.
  */
+
+/**
+ * Build a decoder working on the given image and configured by the given
+ * properties. This lets plug-ins providing several decoder engines select
+ * one of them (see @ref DECODER_ENGINE). The default implementation ignores
+ * the properties and calls decode(gel::Image *).
+ * @param image		Image to decode in.
+ * @param props		Configuration properties.
+ * @return			Decoder for the image.
+ */
+Decoder *DecoderPlugin::decode(gel::Image *image, const PropList& props) {
+	return decode(image);
+}
 	
 }	// otawa
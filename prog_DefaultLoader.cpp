@@ -19,15 +19,27 @@
  *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
 #include <elm/avl/Map.h>
+#include <elm/data/Vector.h>
+#include <elm/io/OutFileStream.h>
 #include <elm/sys/Plugger.h>
 
 #include <gel++.h>
 #include <gel++/Image.h>
 
+#include <otawa/prog/BlockTable.h>
+#include <otawa/prog/DecodeCache.h>
 #include <otawa/prog/Decoder.h>
 #include <otawa/prog/DefaultLoader.h>
+#include <otawa/prog/FileMap.h>
 #include <otawa/prog/Process.h>
+#include <otawa/prog/SymbolIndex.h>
 #include <otawa/otawa.h>
 
 namespace otawa {
@@ -41,6 +53,124 @@ public:
 
 class DefaultProcess;
 
+/**
+ * Scoped load phase: notifies the observer, if any, of the beginning
+ * and of the end of the phase.
+ */
+class Phase {
+public:
+	inline Phase(LoadObserver *observer, cstring name): _obs(observer), _name(name)
+		{ if(_obs != nullptr) _obs->beginPhase(_name); }
+	inline ~Phase()
+		{ if(_obs != nullptr) _obs->endPhase(_name); }
+private:
+	LoadObserver *_obs;
+	cstring _name;
+};
+
+/**
+ * Load observer recording the load phases and the first-time decoding
+ * of instructions as a trace in the Chrome trace-event format (readable by
+ * chrome://tracing or Perfetto). The phases are also forwarded to the
+ * observer set by the user, if any.
+ */
+class Tracer: public LoadObserver {
+public:
+	static const int MAX_DECODES = 100000;
+
+	Tracer(LoadObserver *next): _next(next), _origin(now()), _decodes(0), _dropped(0) { }
+
+	void beginPhase(cstring name) override {
+		_events.add(event_t(name, 'B', now() - _origin));
+		if(_next != nullptr)
+			_next->beginPhase(name);
+	}
+
+	void endPhase(cstring name) override {
+		_events.add(event_t(name, 'E', now() - _origin));
+		if(_next != nullptr)
+			_next->endPhase(name);
+	}
+
+	// record the first-time decoding of the instruction at a, started at start
+	inline void decoded(t::uint64 a, t::uint64 start) {
+		if(_decodes == MAX_DECODES) {
+			_dropped++;
+			return;
+		}
+		_decodes++;
+		event_t e("decode", 'X', start - _origin);
+		e.dur = now() - start;
+		e.addr = a;
+		_events.add(e);
+	}
+
+	// write the trace to the given path ("-" for the standard error)
+	void write(const string& path) {
+		if(path == "-") {
+			write(cerr);
+			return;
+		}
+		io::OutFileStream stream(path.toCString());
+		if(!stream.isReady()) {
+			cerr << "WARNING: cannot write the load trace to " << path << io::endl;
+			return;
+		}
+		io::Output out(stream);
+		write(out);
+	}
+
+	static inline t::uint64 now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+
+	typedef struct event_t {
+		inline event_t(cstring n = "", char p = 'B', t::uint64 t = 0)
+			: name(n), ph(p), ts(t), dur(0), addr(0) { }
+		cstring name;
+		char ph;
+		t::uint64 ts, dur, addr;
+	} event_t;
+
+	void write(io::Output& out) {
+		int pid = getpid();
+		char buf[32];
+		out << "{\"traceEvents\":[";
+		for(int i = 0; i < _events.count(); i++) {
+			const auto& e = _events[i];
+			out << (i == 0 ? "\n" : ",\n")
+				<< "{\"name\":\"" << e.name << "\",\"cat\":\""
+				<< (e.ph == 'X' ? "decode" : "load")
+				<< "\",\"ph\":\"" << e.ph << "\",\"ts\":" << micros(buf, e.ts);
+			if(e.ph == 'X') {
+				out << ",\"dur\":" << micros(buf, e.dur);
+				snprintf(buf, sizeof(buf), "%llx", static_cast<unsigned long long>(e.addr));
+				out << ",\"args\":{\"address\":\"0x" << buf << "\"}";
+			}
+			out << ",\"pid\":" << pid << ",\"tid\":" << pid << "}";
+		}
+		out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_decodes\":\""
+			<< _dropped << "\"}}\n";
+	}
+
+	// format nanoseconds as microseconds, the unit of trace-event timestamps
+	static const char *micros(char *buf, t::uint64 ns) {
+		snprintf(buf, 32, "%llu.%03llu",
+			static_cast<unsigned long long>(ns / 1000),
+			static_cast<unsigned long long>(ns % 1000));
+		return buf;
+	}
+
+	LoadObserver *_next;
+	t::uint64 _origin;
+	Vector<event_t> _events;
+	int _decodes;
+	t::uint64 _dropped;
+};
+
 class DefaultSegment: public Segment {
 public:
 	DefaultSegment(
@@ -48,18 +178,79 @@ public:
 		cstring name,
 		address_t address,
 		ot::size size,
-		flags_t flags
-	): Segment(name, address, size, flags), decoder(d) {
+		flags_t flags,
+		Tracer *tracer = nullptr
+	): Segment(name, address, size, flags), decoder(d), _tracer(tracer) {
 	}
+
+	/**
+	 * Decode the whole segment in one pass with Decoder::decodeRange()
+	 * and record the instructions in the segment. While they are recorded,
+	 * decode() looks them up by address, whatever the order in which the
+	 * segment asks for them.
+	 */
+	void decodeAll() {
+		Collector coll(pre);
+		decoder.decodeRange(address().offset(), topAddress().offset(), coll);
+		for(int i = 0; i < pre.count(); i++)
+			findInstAt(pre[i]->address());
+		pre.clear();
+	}
+
 protected:
 	Inst *decode(address_t address) override {
-		return decoder.decode(address.offset());
+		auto i = predecoded(address);
+		if(i != nullptr)
+			return i;
+		if(_tracer == nullptr)
+			return decoder.decode(address.offset());
+		auto start = Tracer::now();
+		i = decoder.decode(address.offset());
+		_tracer->decoded(address.offset(), start);
+		return i;
 	}
+
 private:
+
+	// find a pre-decoded instruction (they are sorted by address)
+	Inst *predecoded(Address a) const {
+		int l = 0, h = pre.count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(pre[m]->address() < a)
+				l = m + 1;
+			else
+				h = m;
+		}
+		return l < pre.count() && pre[l]->address() == a ? pre[l] : nullptr;
+	}
+
+	class Collector: public Decoder::Sink {
+	public:
+		Collector(Vector<Inst *>& insts): _insts(insts) { }
+		void put(Inst *inst) override { _insts.add(inst); }
+	private:
+		Vector<Inst *>& _insts;
+	};
+
 	Decoder& decoder;
+	Vector<Inst *> pre;
+	Tracer *_tracer;
 };
 
-class DefaultProcess: public Process {
+// The decoder owns the memory of the instructions: it must be released
+// after the Process part that destroys the instructions.
+class DecoderHolder {
+protected:
+	DecoderHolder(): decoder(nullptr) { }
+	~DecoderHolder() {
+		if(decoder != nullptr)
+			delete decoder;
+	}
+	Decoder *decoder;
+};
+
+class DefaultProcess: private DecoderHolder, public Process {
 	friend class DefaultLoader;
 public:
 	
@@ -70,23 +261,57 @@ public:
 	):
 		Process(manager, props, program),
 		image(nullptr),
+		index(nullptr),
 		pf(nullptr),
-		decoder(nullptr),
-		start_inst(nullptr)
-	{ }
+		symbols(nullptr),
+		blocks(nullptr),
+		start_inst(nullptr),
+		predecode(PREDECODE(props)),
+		threads(PREDECODE_THREADS(props)),
+		engine(DECODER_ENGINE(props)),
+		observer(LOAD_OBSERVER(props)),
+		lazy_symbols(LAZY_SYMBOLS(props)),
+		cache_dir(DECODE_CACHE(props)),
+		discover(DISCOVER(props)),
+		lazy(DECODE_LAZY(props)),
+		stats_path(DECODE_STATS(props)),
+		trace_path(LOAD_TRACE(props)),
+		tracer(nullptr)
+	{
+		if(stats_path.isEmpty() && getenv("OTAWA_DECODE_STATS") != nullptr)
+			stats_path = getenv("OTAWA_DECODE_STATS");
+		if(trace_path.isEmpty() && getenv("OTAWA_LOAD_TRACE") != nullptr)
+			trace_path = getenv("OTAWA_LOAD_TRACE");
+		if(!trace_path.isEmpty()) {
+			tracer = new Tracer(observer);
+			observer = tracer;
+		}
+	}
 	
 	~DefaultProcess() {
+		if(decoder != nullptr && !stats_path.isEmpty())
+			dumpStats();
+		if(tracer != nullptr) {
+			tracer->write(trace_path);
+			delete tracer;
+		}
+		if(index != nullptr)
+			delete index;
+		if(symbols != nullptr)
+			delete symbols;
+		if(blocks != nullptr)
+			delete blocks;
 		if(image != nullptr)
 			delete image;
-		if(pf != nullptr)
-			delete pf;
 	}
 
 	hard::Platform *platform() override { return pf; }
 	
 	Inst *start() override {
-		if(start_inst == nullptr)
+		if(start_inst == nullptr) {
+			Phase phase(observer, "start");
 			start_inst = findInstAt(start_addr);
+		}
 		return start_inst;
 	}
 	
@@ -94,90 +319,49 @@ public:
 		return decoder->instSize();
 	}
 
+	// with LAZY_SYMBOLS, the symbols not built yet are not visible through
+	// the files: they are looked up by name in the index and built if found
+	Address findLabel(const string& label) override {
+		if(symbols != nullptr && !symbols->isMaterialized()) {
+			auto e = symbols->find(label);
+			if(e != nullptr)
+				return symbols->symbol(*e)->address();
+		}
+		return Process::findLabel(label);
+	}
+
 	void get(Address at, Address &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
 		t::uint32 a;
-		b.get(at.offset() - s->baseAddress(), a);
+		read(at, a);
 		val = a;
 	}
 	
 	void get(Address at, char *buf, int size) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		cstring cs;
-		b.get(at.offset() - s->baseAddress(), cs);
-		ASSERT(cs.length() >= size);
-		for(const char *p = cs.chars(); *p != '\0'; p++)
-			*buf++ = *p++;
-		*buf++ = '\0';
+		ASSERT(size > 0);
+		auto s = segment(at);
+		int n = s->stringLength(at.offset());
+		if(n < 0 || n > size - 1)
+			n = size - 1;
+		s->read(at.offset(), buf, n);
+		buf[n] = '\0';
 	}
 	
 	void get(Address at, string &str) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		string cs;
-		b.get(at.offset() - s->baseAddress(), cs);		
-	}
-
-	void get(Address at, t::int8 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::uint8 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::int16 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::uint16 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::int32 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::uint32 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
+		auto s = segment(at);
+		int n = s->stringLength(at.offset());
+		if(n < 0)
+			n = s->top() - at.offset();
+		str = string(reinterpret_cast<const char *>(s->bytes() + (at.offset() - s->base())), n);
 	}
 
-	void get(Address at, t::int64 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
-
-	void get(Address at, t::uint64 &val) override {
-		auto s = image->at(at.offset());
-		ASSERT(s != nullptr);
-		auto b = s->buffer();
-		b.get(at.offset() - s->baseAddress(), val);
-	}
+	void get(Address at, t::int8 &val) override { read(at, val); }
+	void get(Address at, t::uint8 &val) override { read(at, val); }
+	void get(Address at, t::int16 &val) override { read(at, val); }
+	void get(Address at, t::uint16 &val) override { read(at, val); }
+	void get(Address at, t::int32 &val) override { read(at, val); }
+	void get(Address at, t::uint32 &val) override { read(at, val); }
+	void get(Address at, t::int64 &val) override { read(at, val); }
+	void get(Address at, t::uint64 &val) override { read(at, val); }
 
 	File *loadFile(elm::CString path) override {
 		if(image != nullptr)
@@ -185,62 +369,142 @@ public:
 		try {
 			
 			// build the image
-			auto f = gel::Manager::open(path);
-			image = f->make();
+			gel::File *f;
+			{
+				Phase phase(observer, "open");
+				f = gel::Manager::open(path);
+			}
+			{
+				Phase phase(observer, "image");
+				image = f->make();
+				index = new SegmentIndex(image);
+				SEGMENT_INDEX(this) = index;
+			}
 			auto of = new File(path);
 			addFile(of);
 			start_addr = f->entry();
 
 			// create the decoder
-			string mach = _ << "elf_" << f->elfMachine();
-			auto plugin = static_cast<DecoderPlugin *>(decoder_plugger.plug(mach));
-			if(plugin == nullptr)
-				throw otawa::Exception(_ << "cannot open " << path << ": no decoder for " << mach);
-			decoder = plugin->decode(image);
-			pf = decoder->platform();
+			{
+				Phase phase(observer, "decoder");
+				string mach = _ << "elf_" << f->elfMachine();
+				auto plugin = static_cast<DecoderPlugin *>(decoder_plugger.plug(mach));
+				if(plugin == nullptr)
+					throw otawa::Exception(_ << "cannot open " << path << ": no decoder for " << mach);
+				PropList dprops;
+				if(!engine.isEmpty())
+					DECODER_ENGINE(dprops) = engine;
+				ELF_MACHINE(dprops) = f->elfMachine();
+				if(!stats_path.isEmpty())
+					DECODE_STATS(dprops) = stats_path;
+				if(lazy)
+					DECODE_LAZY(dprops) = true;
+				decoder = plugin->decode(image, dprops);
+				decoder->useSegments(index);
+				pf = decoder->platform();
+			}
 			
 			// parse all segments
 			avl::Map<gel::File *, File *> map;
+			Vector<DefaultSegment *> exec;
 			map.put(f, of);
-			for(auto s: image->segments()) {
-				if(s->file() == nullptr) {
-					if(s->isStack())
-						stack_top = s->base() + s->size();
-					continue;
+			{
+				Phase phase(observer, "segments");
+				for(auto s: image->segments()) {
+					if(s->file() == nullptr) {
+						if(s->isStack())
+							stack_top = s->base() + s->size();
+						continue;
+					}
+					auto cf = map.get(s->file(), nullptr);
+					if(cf == nullptr) {
+						cf = new File(s->file()->path());
+						addFile(cf);
+						map.put(s->file(), cf);
+					}
+					Segment::flags_t flags = 0;
+					if(s->isExecutable())
+						flags |= Segment::EXECUTABLE;
+					if(s->isWritable())
+						flags |= Segment::WRITABLE;
+					if(s->hasContent())
+						flags |= Segment::INITIALIZED;
+					auto os = new DefaultSegment(*decoder, s->name(), s->base(), s->size(), flags, tracer);
+					cf->addSegment(os);
+					if(s->isExecutable())
+						exec.add(os);
 				}
-				auto cf = map.get(s->file(), nullptr);
-				if(cf == nullptr) {
-					cerr << "DEBUG: added file " << s->file()->path() << io::endl;
-					cf = new File(s->file()->path());
-					addFile(cf);
-					map.put(s->file(), cf);
+			}
+
+			// open the decode cache
+			string cache_id, cache_path;
+			t::uint64 cache_hash = 0;
+			bool cached = false;
+			if(!cache_dir.isEmpty()) {
+				Phase phase(observer, "cache");
+				cache_id = decoder->cacheId();
+				if(!cache_id.isEmpty()) {
+					cache_hash = hashFile(path);
+					cache_path = cachePath(cache_hash, cache_id);
+					DecodeCache::Reader reader(cache_path.toCString(), cache_id.toCString(), cache_hash);
+					cached = reader.isValid() && decoder->loadCache(reader);
 				}
-				Segment::flags_t flags = 0;
-				if(s->isExecutable())
-					flags |= Segment::EXECUTABLE;
-				if(s->isWritable())
-					flags |= Segment::WRITABLE;
-				if(s->hasContent())
-					flags |= Segment::INITIALIZED;
-				auto os = new DefaultSegment(*decoder, s->name(), s->base(), s->size(), flags);
-				cf->addSegment(os);
 			}
-			
+			bool full = predecode || (!cache_id.isEmpty() && !cached);
+
 			// load the symbols
-			for(auto p: map.pairs()) {
-				auto& st = p.fst->symbols();
-				for(auto s: st) {
-					auto k = Symbol::NONE;
-					switch(s->type()) {
-					case gel::Symbol::FUNC:			k = Symbol::FUNCTION; break;
-					case gel::Symbol::DATA:			k = Symbol::DATA; break;
-					case gel::Symbol::OTHER_TYPE:	k = Symbol::LABEL; break;
-					default:						break;
+			Vector<gel::address_t> starts;
+			{
+				Phase phase(observer, "symbols");
+				symbols = new SymbolIndex();
+				for(auto p: map.pairs()) {
+					auto& st = p.fst->symbols();
+					for(auto s: st) {
+						if((full || discover) && s->type() == gel::Symbol::FUNC)
+							starts.add(s->value());
+						symbols->add(p.snd, s);
 					}
-					p.snd->addSymbol(new Symbol(*p.snd, s->name(), k, s->value(), s->size()));
+				}
+				symbols->build();
+				if(!lazy_symbols)
+					symbols->materializeAll();
+				SYMBOL_INDEX(this) = symbols;
+			}
+
+			// pre-decode the code (the instructions of the pre-decoded or cached code are
+			// then created on demand, they are only recorded in the segments if PREDECODE is set)
+			if(cached || full) {
+				Phase phase(observer, "predecode");
+				if(!cached) {
+					starts.add(start_addr.offset());
+					std::sort(&starts[0], &starts[0] + starts.count());
+					for(auto os: exec)
+						decoder->predecode(os->address().offset(), os->topAddress().offset(), starts, threads);
+				}
+				if(predecode)
+					for(auto os: exec)
+						os->decodeAll();
+			}
+
+			// save the decode cache
+			if(!cache_id.isEmpty() && !cached) {
+				Phase phase(observer, "cache");
+				DecodeCache::Writer writer(cache_path.toCString(), cache_id.toCString(), cache_hash);
+				if(writer.isOpen()) {
+					decoder->saveCache(writer);
+					writer.close();
 				}
 			}
 			
+			// discover the code
+			if(discover) {
+				Phase phase(observer, "discover");
+				starts.add(start_addr.offset());
+				blocks = new BlockTable(*index);
+				decoder->discover(starts, *blocks);
+				BLOCK_TABLE(this) = blocks;
+			}
+
 			return of;
 		}
 		catch(gel::Exception& e) {
@@ -249,14 +513,230 @@ public:
 	}
 
 private:
+
+	inline const SegmentIndex::Entry *segment(Address at) const {
+		auto s = index->at(at.offset());
+		ASSERT(s != nullptr);
+		return s;
+	}
+
+	// hash of the executable file for the decode cache
+	t::uint64 hashFile(cstring path) {
+		FileMap map(path);
+		return DecodeCache::hash(map.data(), map.size());
+	}
+
+	// path of the decode cache file
+	string cachePath(t::uint64 hash, const string& id) {
+		char buf[17];
+		snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+		StringBuffer name;
+		for(int i = 0; i < id.length(); i++)
+			name << (id[i] == '/' ? '-' : id[i]);
+		return _ << cache_dir << '/' << buf << '-' << name.toString() << ".cache";
+	}
+
+	// write the decoder statistics ("-" for the standard error)
+	void dumpStats() {
+		if(stats_path == "-") {
+			decoder->dumpStats(cerr);
+			return;
+		}
+		io::OutFileStream stream(stats_path.toCString());
+		if(!stream.isReady()) {
+			cerr << "WARNING: cannot write the decoder statistics to " << stats_path << io::endl;
+			return;
+		}
+		io::Output out(stream);
+		decoder->dumpStats(out);
+	}
+
+	// read a little-endian value
+	template <class T>
+	inline void read(Address at, T& val) const {
+		segment(at)->read(at.offset(), &val, 1);
+	}
+
 	gel::Image *image;
+	SegmentIndex *index;
 	hard::Platform *pf;
+	SymbolIndex *symbols;
+	BlockTable *blocks;
 	Address stack_top, start_addr;
-	Decoder *decoder;
 	Inst *start_inst;
+	bool predecode;
+	int threads;
+	string engine;
+	LoadObserver *observer;
+	bool lazy_symbols;
+	string cache_dir;
+	bool discover;
+	bool lazy;
+	string stats_path;
+	string trace_path;
+	Tracer *tracer;
 };
 
-	
+
+/**
+ * Configuration property of DefaultLoader: if set to true, the executable
+ * segments are decoded entirely at load time, in one pass per segment,
+ * using Decoder::decodeRange(), and their instructions are recorded in
+ * the segments. Without it, the code pre-decoded for the decode cache only
+ * gives its instructions when they are requested.
+ * @ingroup prog
+ */
+Identifier<bool> PREDECODE("otawa::PREDECODE", false);
+
+/**
+ * Configuration property of DefaultLoader: maximum number of threads used
+ * to pre-decode the executable segments when @ref PREDECODE is set.
+ * 0 (default) means as many threads as available cores.
+ * @ingroup prog
+ */
+Identifier<int> PREDECODE_THREADS("otawa::PREDECODE_THREADS", 0);
+
+/**
+ * Configuration property of DefaultLoader and of DecoderPlugin: name of the
+ * decoder engine to use when the decoder plug-in provides several of them.
+ * Empty (default) selects the default engine of the plug-in.
+ * @ingroup prog
+ */
+Identifier<string> DECODER_ENGINE("otawa::DECODER_ENGINE", "");
+
+/**
+ * Property passed by DefaultLoader to DecoderPlugin::decode(): ELF machine
+ * number of the executable. It lets a plug-in supporting several machines,
+ * or several modes of a machine, select the matching decoder.
+ * Default to 0 (unknown).
+ * @ingroup prog
+ */
+Identifier<int> ELF_MACHINE("otawa::ELF_MACHINE", 0);
+
+/**
+ * Configuration property of DefaultLoader: if set to true, the symbols of
+ * the program are only recorded in the @ref SymbolIndex of the process at
+ * load time and the otawa::Symbol objects are built on demand, with
+ * SymbolIndex::symbol() or SymbolIndex::materializeAll(). Until then,
+ * the symbols are not visible through the files of the process, except
+ * for Process::findLabel() and Process::findInstAt() with a label, that
+ * build the looked symbol.
+ * @ingroup prog
+ */
+Identifier<bool> LAZY_SYMBOLS("otawa::LAZY_SYMBOLS", false);
+
+/**
+ * Configuration property of DefaultLoader: directory of the decode caches.
+ * If set, and if the decoder supports caching, the decoded instructions
+ * are looked up in a cache file of this directory, bound to the content
+ * of the executable and to the decoder version (see DecodeCache). If the
+ * cache is missing or stale, the executable segments are pre-decoded and
+ * the cache file is written. Default to empty (no cache).
+ * @ingroup prog
+ */
+Identifier<string> DECODE_CACHE("otawa::DECODE_CACHE", "");
+
+/**
+ * Configuration property of DefaultLoader: if set to true, the code of
+ * the program is discovered at load time by recursive descent from the
+ * program entry, the function symbols and the decoder-specific markers
+ * (see Decoder::discover()). The resulting basic blocks are provided by
+ * @ref BLOCK_TABLE. Default to false.
+ * @ingroup prog
+ */
+Identifier<bool> DISCOVER("otawa::DISCOVER", false);
+
+/**
+ * Configuration property of DefaultLoader: if set, the decoder collects
+ * statistics (decoded and unknown instructions, prefixes, cache hits,
+ * decoding time, etc) that are written as JSON to the given path ("-" for
+ * the standard error) when the process is released. If not set, the
+ * environment variable OTAWA_DECODE_STATS is used instead. Decoders not
+ * supporting statistics ignore it. Default to empty (no statistics).
+ * @ingroup prog
+ */
+Identifier<string> DECODE_STATS("otawa::DECODE_STATS", "");
+
+/**
+ * Configuration property of DefaultLoader: if set to true, the decoder
+ * only computes the length and the kind of the instructions when they are
+ * first decoded (and the branch targets of the control instructions): the
+ * other operands and the used registers are decoded at the first access
+ * (Inst::dump(), Inst::readRegSet(), Inst::semInsts(), etc). This speeds up
+ * the passes only needing the instruction boundaries and the control flow.
+ * Decoders not supporting it ignore it. Default to false.
+ * @ingroup prog
+ */
+Identifier<bool> DECODE_LAZY("otawa::DECODE_LAZY", false);
+
+/**
+ * Configuration property of DefaultLoader: if set, the load phases (see
+ * @ref LoadObserver) and the first-time decoding of each instruction are
+ * traced and written in the Chrome trace-event JSON format (chrome://tracing,
+ * Perfetto) to the given path ("-" for the standard error) when the process
+ * is released. Only the first 100,000 decodings are recorded. If not set,
+ * the environment variable OTAWA_LOAD_TRACE is used instead. The
+ * @ref LOAD_OBSERVER, if any, is still notified. Default to empty (no trace).
+ * @ingroup prog
+ */
+Identifier<string> LOAD_TRACE("otawa::LOAD_TRACE", "");
+
+/**
+ * Property of the processes built by DefaultLoader giving the basic blocks
+ * found when @ref DISCOVER is set (owned by the process).
+ * @ingroup prog
+ */
+Identifier<BlockTable *> BLOCK_TABLE("otawa::BLOCK_TABLE", nullptr);
+
+/**
+ * Property of the processes built by DefaultLoader giving the index of
+ * the program segments (owned by the process). It provides bulk memory
+ * reads, SegmentIndex::read(), costing only one segment look-up for
+ * a whole array.
+ * @ingroup prog
+ */
+Identifier<SegmentIndex *> SEGMENT_INDEX("otawa::SEGMENT_INDEX", nullptr);
+
+/**
+ * Property of the processes built by DefaultLoader giving the index of
+ * the program symbols by address (owned by the process).
+ * @ingroup prog
+ */
+Identifier<SymbolIndex *> SYMBOL_INDEX("otawa::SYMBOL_INDEX", nullptr);
+
+/**
+ * @class LoadObserver
+ * Observer of the phases of the program loading performed by DefaultLoader:
+ * "open" (file opening), "image" (image building), "decoder" (decoder
+ * creation), "cache" (decode cache look-up, only if @ref DECODE_CACHE is set),
+ * "segments", "symbols", "predecode" (only if @ref PREDECODE is set or the
+ * decode cache is used), "cache" again (decode cache saving), "discover"
+ * (only if @ref DISCOVER is set) and "start" (first call to Process::start()).
+ * @ingroup prog
+ */
+
+///
+LoadObserver::~LoadObserver() { }
+
+/**
+ * @fn void LoadObserver::beginPhase(cstring name);
+ * Called at the beginning of a load phase.
+ * @param name	Phase name.
+ */
+
+/**
+ * @fn void LoadObserver::endPhase(cstring name);
+ * Called at the end of a load phase.
+ * @param name	Phase name.
+ */
+
+/**
+ * Configuration property of DefaultLoader: observer notified of the
+ * load phases (ownership kept by the caller). Default to null.
+ * @ingroup prog
+ */
+Identifier<LoadObserver *> LOAD_OBSERVER("otawa::LOAD_OBSERVER", nullptr);
+
 /**
  * @class DefaultLoader
  * Default loader implementation using a @ref Decoder to decode instructions.
@@ -0,0 +1,86 @@
+/*
+ *	FileMap class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <otawa/base.h>
+#include <otawa/prog/FileMap.h>
+
+namespace otawa {
+
+/**
+ * @class FileMap
+ * Read-only memory mapping of a file. The file is mapped shared so that
+ * the pages are loaded on demand and shared between all the processes
+ * mapping the same file. It is used to read the decode caches and to hash
+ * the executable files.
+ *
+ * @ingroup prog
+ */
+
+/**
+ * Map the given file.
+ * @param path	Path of the file to map.
+ * @throw otawa::Exception	If the file cannot be mapped.
+ */
+FileMap::FileMap(cstring path): _data(nullptr), _size(0) {
+	int fd = open(path.chars(), O_RDONLY);
+	if(fd < 0)
+		throw otawa::Exception(_ << "cannot open " << path << ": " << strerror(errno));
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		int err = errno;
+		close(fd);
+		throw otawa::Exception(_ << "cannot open " << path << ": " << strerror(err));
+	}
+	_size = st.st_size;
+	void *p = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+	int err = errno;
+	close(fd);
+	if(p == MAP_FAILED)
+		throw otawa::Exception(_ << "cannot map " << path << ": " << strerror(err));
+	_data = static_cast<const t::uint8 *>(p);
+}
+
+///
+FileMap::~FileMap() {
+	if(_data != nullptr)
+		munmap(const_cast<t::uint8 *>(_data), _size);
+}
+
+/**
+ * @fn const t::uint8 *FileMap::data() const;
+ * Get the mapped bytes.
+ * @return	Start of the mapping.
+ */
+
+/**
+ * @fn t::size FileMap::size() const;
+ * Get the size of the mapping.
+ * @return	Mapping size (in bytes).
+ */
+
+}	// otawa
@@ -0,0 +1,89 @@
+/*
+ *	InstCache class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <otawa/prog/InstCache.h>
+
+namespace otawa {
+
+/**
+ * @class InstCache
+ * Cache of the instructions decoded in a segment, indexed by address.
+ * It is organized as a two-level page table: the first level is an array
+ * of pages covering the segment and a page, allocated on the first
+ * recorded instruction, provides one slot by byte offset.
+ *
+ * This ensures that a decoder returns the same instruction object each
+ * time it is asked for the same address.
+ *
+ * @ingroup prog
+ */
+
+/**
+ * Build a cache for the given address range.
+ * @param base	Base address of the range.
+ * @param size	Size of the range (in bytes).
+ */
+InstCache::InstCache(gel::address_t base, t::uint32 size)
+	: _base(base), _count((size + PAGE_SIZE - 1) >> PAGE_BITS), _pages(new Inst **[_count]()), _hits(0), _misses(0) {
+}
+
+///
+InstCache::~InstCache() {
+	for(t::uint32 i = 0; i < _count; i++)
+		if(_pages[i] != nullptr)
+			delete [] _pages[i];
+	delete [] _pages;
+}
+
+/**
+ * @fn Inst *InstCache::get(gel::address_t a) const;
+ * Get the instruction recorded at the given address.
+ * @param a		Instruction address (must be in the cache range).
+ * @return		Recorded instruction or null.
+ */
+
+/**
+ * @fn Inst *InstCache::find(gel::address_t a);
+ * Same as get() but also updates the hit and miss counters.
+ * @param a		Instruction address (must be in the cache range).
+ * @return		Recorded instruction or null.
+ */
+
+/**
+ * @fn void InstCache::put(gel::address_t a, Inst *inst);
+ * Record an instruction.
+ * @param a		Instruction address (must be in the cache range).
+ * @param inst	Recorded instruction.
+ */
+
+/**
+ * @fn t::uint64 InstCache::hits() const;
+ * Get the number of successful look-ups with find().
+ * @return	Hit count.
+ */
+
+/**
+ * @fn t::uint64 InstCache::misses() const;
+ * Get the number of failed look-ups with find().
+ * @return	Miss count.
+ */
+
+}	// otawa
@@ -0,0 +1,68 @@
+/*
+ *	JumpTable class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <otawa/prog/JumpTable.h>
+
+namespace otawa {
+
+/**
+ * @class JumpTable
+ * Table of targets of an indirect branch recovered by the decoder, typically
+ * from the code generated for a switch statement. The targets are given in
+ * the order of the table: they may contain duplicates.
+ * @ingroup prog
+ */
+
+/**
+ * Build a jump table.
+ * @param address	Address of the table in memory.
+ * @param targets	Targets of the table, in table order.
+ */
+JumpTable::JumpTable(gel::address_t address, const Vector<gel::address_t>& targets)
+	: _address(address), _targets(targets) { }
+
+/**
+ * @fn gel::address_t JumpTable::address() const;
+ * Get the address of the table in memory.
+ * @return	Table address.
+ */
+
+/**
+ * @fn int JumpTable::count() const;
+ * Get the number of entries of the table.
+ * @return	Entry count.
+ */
+
+/**
+ * @fn gel::address_t JumpTable::operator[](int i) const;
+ * Get a target of the table.
+ * @param i		Entry index.
+ * @return		Target address.
+ */
+
+/**
+ * Property put by decoders on indirect branch instructions whose targets
+ * have been recovered from a jump table (owned by the decoder).
+ * @ingroup prog
+ */
+Identifier<JumpTable *> JUMP_TABLE("otawa::JUMP_TABLE", nullptr);
+
+}	// otawa
@@ -0,0 +1,73 @@
+/*
+ *	RegMask class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <otawa/prog/RegMask.h>
+
+namespace otawa {
+
+/**
+ * @class RegMask
+ * Interface of the instructions providing the registers they read and
+ * write as bit masks: bit n of a mask stands for the register whose
+ * platform number is n. This lets data-flow analyses work on registers
+ * with bitwise operations instead of building RegSet objects. It is
+ * only available for platforms with at most MAX registers.
+ *
+ * The masks are closed under register aliasing: an access to a register
+ * is also an access to the registers sharing bits with it.
+ *
+ * @ingroup prog
+ */
+
+///
+RegMask::~RegMask() {
+}
+
+/**
+ * @fn mask_t RegMask::readMask() const;
+ * Get the mask of the registers read by the instruction, including the
+ * implicit ones.
+ * @return	Read register mask.
+ */
+
+/**
+ * @fn mask_t RegMask::writeMask() const;
+ * Get the mask of the registers written by the instruction, including the
+ * implicit ones.
+ * @return	Written register mask.
+ */
+
+/**
+ * @fn RegMask *RegMask::of(Inst *inst);
+ * Get the register mask interface of an instruction.
+ * @param inst	Instruction to look.
+ * @return		Register mask interface or null if the instruction does not
+ * 				provide it.
+ */
+
+/**
+ * @fn void RegMask::fill(mask_t mask, RegSet& set);
+ * Add the registers of a mask to a register set.
+ * @param mask	Register mask.
+ * @param set	Set to add to.
+ */
+
+}	// otawa
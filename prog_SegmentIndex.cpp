@@ -0,0 +1,191 @@
+/*
+ *	SegmentIndex class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+#include <otawa/prog/SegmentIndex.h>
+
+namespace otawa {
+
+/**
+ * @class SegmentIndex
+ * Immutable index of the segments of an image sorted by address.
+ * Look-up of the segment containing an address first checks the
+ * last found segment and then falls back to a binary search.
+ *
+ * The index is built once, after the image construction, and shared
+ * between the process memory accessors and the decoder.
+ *
+ * @ingroup prog
+ */
+
+/**
+ * @class SegmentIndex::Entry
+ * Entry of a SegmentIndex, that is, the address range of an image
+ * segment and its rank in the index.
+ */
+
+/**
+ * @fn const t::uint8 *SegmentIndex::Entry::bytes() const;
+ * Get the content of the segment, that is, the bytes of the image buffer.
+ * @return	Segment content (starting at the segment base).
+ */
+
+/**
+ * @fn t::uint32 SegmentIndex::Entry::available() const;
+ * Get the number of bytes of the segment actually stored, the remaining
+ * bytes (up to the segment size) being considered as null.
+ * @return	Stored byte count.
+ */
+
+/**
+ * @fn void SegmentIndex::Entry::read(gel::address_t a, T *buf, int count) const;
+ * Read count little-endian values of type T starting at address a. The read
+ * range must be contained in the segment. On little-endian hosts, the
+ * values are copied at once.
+ * @param a		Address to read from.
+ * @param buf	Buffer receiving the values.
+ * @param count	Number of values to read.
+ */
+
+// find the first null byte in [p, e[
+static const t::uint8 *findNull(const t::uint8 *p, const t::uint8 *e) {
+#	ifdef __SSE2__
+		while(p < e && (t::uintptr(p) & 15) != 0) {
+			if(*p == 0)
+				return p;
+			p++;
+		}
+		const __m128i zero = _mm_setzero_si128();
+		for(; p + 16 <= e; p += 16) {
+			int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(p)), zero));
+			if(m != 0)
+				return p + __builtin_ctz(m);
+		}
+#	endif
+	for(; p < e; p++)
+		if(*p == 0)
+			return p;
+	return nullptr;
+}
+
+/**
+ * Get the length of the null-terminated string at the given address.
+ * The bytes are scanned 16 at a time when SSE2 is available.
+ * @param a		String address (must be in the segment).
+ * @return		String length or -1 if the string is not terminated
+ * 				in the stored bytes of the segment.
+ */
+int SegmentIndex::Entry::stringLength(gel::address_t a) const {
+	t::uint32 o = a - _base, av = available();
+	if(o >= av)
+		return 0;
+	const t::uint8 *p = bytes() + o, *q = findNull(p, bytes() + av);
+	if(q == nullptr)
+		return av == size() ? -1 : av - o;
+	return q - p;
+}
+
+/**
+ * Build the index for the given image. Empty segments are ignored.
+ * @param image		Image to index.
+ */
+SegmentIndex::SegmentIndex(gel::Image *image): _entries(nullptr), _count(0), _last(nullptr) {
+	int n = 0;
+	for(auto s: image->segments())
+		if(s->size() != 0)
+			n++;
+	_entries = new Entry[n];
+	for(auto s: image->segments())
+		if(s->size() != 0) {
+			auto& e = _entries[_count++];
+			e._base = s->baseAddress();
+			e._top = s->baseAddress() + s->size();
+			e._seg = s;
+		}
+	std::sort(_entries, _entries + _count,
+		[](const Entry& e1, const Entry& e2) { return e1._base < e2._base; });
+	for(int i = 0; i < _count; i++)
+		_entries[i]._index = i;
+}
+
+///
+SegmentIndex::~SegmentIndex() {
+	delete [] _entries;
+}
+
+/**
+ * @fn int SegmentIndex::count() const;
+ * Get the number of indexed segments.
+ * @return	Segment count.
+ */
+
+/**
+ * @fn const Entry& SegmentIndex::operator[](int i) const;
+ * Get an entry of the index by its rank in address order.
+ * @param i		Entry rank.
+ * @return		Matching entry.
+ */
+
+/**
+ * @fn const Entry *SegmentIndex::at(gel::address_t a) const;
+ * Look for the segment containing the given address, the last found
+ * segment being tested first.
+ * @param a		Looked address.
+ * @return		Entry of the segment containing a or null.
+ */
+
+/**
+ * Look for the segment containing the given address by binary search.
+ * As this function does not update the last found segment, it can be
+ * called concurrently.
+ * @param a		Looked address.
+ * @return		Entry of the segment containing a or null.
+ */
+const SegmentIndex::Entry *SegmentIndex::lookup(gel::address_t a) const {
+	int l = 0, h = _count;
+	while(l < h) {
+		int m = (l + h) / 2;
+		if(a < _entries[m]._base)
+			h = m;
+		else if(a >= _entries[m]._top)
+			l = m + 1;
+		else
+			return &_entries[m];
+	}
+	return nullptr;
+}
+
+/**
+ * @fn bool SegmentIndex::read(gel::address_t a, T *buf, int count) const;
+ * Read count little-endian values of type T starting at address a with
+ * only one segment look-up. The values are copied at once on
+ * little-endian hosts.
+ * @param a		Address to read from.
+ * @param buf	Buffer receiving the values.
+ * @param count	Number of values to read.
+ * @return		True if the values have been read, false if the range is
+ * 				not contained in a segment.
+ */
+
+}	// otawa
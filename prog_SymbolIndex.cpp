@@ -0,0 +1,253 @@
+/*
+ *	SymbolIndex class implementation
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <otawa/prog/SymbolIndex.h>
+
+namespace otawa {
+
+/**
+ * @class SymbolIndex
+ * Index of the symbols of a program by address. The index records the
+ * symbols of the gel files but the matching otawa::Symbol objects are
+ * only built, and added to their file, when they are requested with
+ * symbol() or materializeAll().
+ *
+ * The function and the data symbols can be looked up by address in
+ * O(log n): their start addresses are stored in Eytzinger order, that is,
+ * as an implicit binary search tree laid out breadth-first, so that the
+ * first levels of the search share the same cache lines. The symbols
+ * can also be looked up by name with find().
+ *
+ * @ingroup prog
+ */
+
+/**
+ * @class SymbolIndex::Entry
+ * Symbol recorded in a SymbolIndex.
+ */
+
+///
+SymbolIndex::SymbolIndex(): _all(false) {
+}
+
+///
+SymbolIndex::~SymbolIndex() {
+}
+
+/**
+ * Record a symbol. build() must be called once all symbols are recorded.
+ * @param file	File containing the symbol.
+ * @param sym	Recorded symbol.
+ */
+void SymbolIndex::add(File *file, gel::Symbol *sym) {
+	Entry e;
+	e._base = sym->value();
+	e._top = sym->value() + sym->size();
+	switch(sym->type()) {
+	case gel::Symbol::FUNC:			e._kind = Symbol::FUNCTION; break;
+	case gel::Symbol::DATA:			e._kind = Symbol::DATA; break;
+	case gel::Symbol::OTHER_TYPE:	e._kind = Symbol::LABEL; break;
+	default:						e._kind = Symbol::NONE; break;
+	}
+	e._gsym = sym;
+	e._file = file;
+	e._sym = nullptr;
+	_entries.add(e);
+}
+
+/**
+ * Build the address tables of function and data symbols.
+ */
+void SymbolIndex::build() {
+	Vector<Entry *> funs, data;
+	for(int i = 0; i < _entries.count(); i++) {
+		auto e = &_entries[i];
+		if(e->_kind == Symbol::FUNCTION)
+			funs.add(e);
+		else if(e->_kind == Symbol::DATA)
+			data.add(e);
+	}
+	_funs.build(funs);
+	_data.build(data);
+}
+
+/**
+ * @fn int SymbolIndex::count() const;
+ * Get the number of recorded symbols.
+ * @return	Symbol count.
+ */
+
+/**
+ * @fn const Entry& SymbolIndex::operator[](int i) const;
+ * Get a recorded symbol by its rank of recording.
+ * @param i		Symbol rank.
+ * @return		Matching entry.
+ */
+
+/**
+ * @fn const Entry *SymbolIndex::function(gel::address_t a) const;
+ * Look for the function containing the given address.
+ * @param a		Looked address.
+ * @return		Function entry or null.
+ */
+
+/**
+ * @fn const Entry *SymbolIndex::data(gel::address_t a) const;
+ * Look for the data symbol containing the given address.
+ * @param a		Looked address.
+ * @return		Data entry or null.
+ */
+
+/**
+ * Look for a symbol by its name. The names are sorted at the first call.
+ * If several symbols have the same name, the first recorded one is found.
+ * @param name	Looked name.
+ * @return		Symbol entry or null.
+ */
+const SymbolIndex::Entry *SymbolIndex::find(cstring name) const {
+	if(_names.count() != _entries.count()) {
+		_names.clear();
+		for(const auto& e: _entries)
+			_names.add(&e);
+		std::stable_sort(&_names[0], &_names[0] + _names.count(), [](const Entry *e1, const Entry *e2)
+			{ return strcmp(e1->name().chars(), e2->name().chars()) < 0; });
+	}
+	int l = 0, h = _names.count();
+	while(l < h) {
+		int m = (l + h) / 2;
+		if(strcmp(_names[m]->name().chars(), name.chars()) < 0)
+			l = m + 1;
+		else
+			h = m;
+	}
+	if(l < _names.count() && strcmp(_names[l]->name().chars(), name.chars()) == 0)
+		return _names[l];
+	return nullptr;
+}
+
+/**
+ * Get the OTAWA symbol of an entry, building it and adding it to its
+ * file if needed.
+ * @param e		Symbol entry.
+ * @return		Matching symbol.
+ */
+Symbol *SymbolIndex::symbol(const Entry& e) const {
+	if(e._sym == nullptr) {
+		e._sym = new Symbol(*e._file, e._gsym->name(), e._kind, e._base, e._top - e._base);
+		e._file->addSymbol(e._sym);
+	}
+	return e._sym;
+}
+
+/**
+ * Build the OTAWA symbols of all recorded symbols, in recording order.
+ */
+void SymbolIndex::materializeAll() const {
+	if(_all)
+		return;
+	for(const auto& e: _entries)
+		symbol(e);
+	_all = true;
+}
+
+/**
+ * @fn bool SymbolIndex::isMaterialized() const;
+ * Test if all symbols have been built.
+ * @return	True if all symbols are built, false else.
+ */
+
+
+///
+SymbolIndex::Table::Table(): _n(0), _nodes(nullptr), _sorted(nullptr), _cover(nullptr) {
+}
+
+///
+SymbolIndex::Table::~Table() {
+	delete [] _nodes;
+	delete [] _sorted;
+	delete [] _cover;
+}
+
+/**
+ * Build the table from the given entries.
+ * @param entries	Entries to index.
+ */
+void SymbolIndex::Table::build(const Vector<Entry *>& entries) {
+	_n = entries.count();
+	_sorted = new Entry *[_n];
+	for(int i = 0; i < _n; i++)
+		_sorted[i] = entries[i];
+
+	// equal addresses: the biggest symbol last
+	std::stable_sort(_sorted, _sorted + _n, [](const Entry *e1, const Entry *e2)
+		{ return e1->_base < e2->_base || (e1->_base == e2->_base && e1->_top < e2->_top); });
+
+	// cover[r] = entry of rank <= r ending last, for nested symbols
+	_cover = new t::uint32[_n];
+	for(int r = 0; r < _n; r++)
+		_cover[r] = r == 0 || _sorted[r]->_top >= _sorted[_cover[r - 1]]->_top ? r : _cover[r - 1];
+
+	// Eytzinger layout (1-based)
+	_nodes = new node_t[_n + 1];
+	fill(0, 1);
+}
+
+// in-order fill of the implicit tree
+int SymbolIndex::Table::fill(int i, int k) {
+	if(k <= _n) {
+		i = fill(i, 2 * k);
+		_nodes[k].key = _sorted[i]->_base;
+		_nodes[k].rank = i;
+		i++;
+		i = fill(i, 2 * k + 1);
+	}
+	return i;
+}
+
+/**
+ * Find the entry containing the given address.
+ * @param a		Looked address.
+ * @return		Found entry or null.
+ */
+const SymbolIndex::Entry *SymbolIndex::Table::lookup(gel::address_t a) const {
+
+	// find the first key greater than a
+	int k = 1;
+	while(k <= _n)
+		k = 2 * k + (_nodes[k].key <= a);
+	k >>= __builtin_ffs(~k);
+	int r = k == 0 ? _n : _nodes[k].rank;
+
+	// check its predecessor and the enclosing entry
+	if(r == 0)
+		return nullptr;
+	r--;
+	if(_sorted[r]->contains(a))
+		return _sorted[r];
+	auto e = _sorted[_cover[r]];
+	if(e->contains(a))
+		return e;
+	return nullptr;
+}
+
+}	// otawa
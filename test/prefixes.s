@@ -0,0 +1,33 @@
+#
+#	Prefix runs around the 15-byte instruction length limit.
+#
+#	This file is part of x86 plug-in for OTAWA.
+#	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+#
+#	OTAWA is free software; you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation; either version 2 of the License, or
+#	(at your option) any later version.
+#
+#	OTAWA is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with OTAWA; if not, write to the Free Software
+#	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# Built freestanding with -m32 -nostdlib -static: the checked code starts
+# at the entry point (see test_decoder.cpp for the expected sizes).
+
+	.text
+	.globl	_start
+_start:
+	.fill	20, 1, 0x66		# 21 bytes: 6 unknown bytes then a 15-byte nop
+	nop
+	.fill	14, 1, 0x66		# 15 bytes: longest valid instruction
+	nop
+	.fill	15, 1, 0x66		# 16 bytes: 1 unknown byte then a 15-byte nop
+	nop
+	hlt
@@ -0,0 +1,47 @@
+/*
+ *	Switch compiled to a jump table.
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Built freestanding with -m32 -O2 -fno-pie -nostdlib -static: GCC
+ * compiles the switch of sel() as a bound check followed by an indirect
+ * jump through a table of 8 entries (case 4 going to the default case).
+ */
+
+volatile int sink;
+
+int sel(int x) {
+	switch(x) {
+	case 0:	sink = 3; break;
+	case 1:	sink = 5; break;
+	case 2:	sink = 7; break;
+	case 3:	sink = 11; break;
+	case 5:	sink = 13; break;
+	case 6:	sink = 17; break;
+	case 7:	sink = 19; break;
+	default: sink = 0; break;
+	}
+	return sink;
+}
+
+void _start(void) {
+	for(int i = 0; ; i++)
+		sel(i & 7);
+}
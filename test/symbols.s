@@ -0,0 +1,56 @@
+#
+#	Function symbols for the SymbolIndex look-ups.
+#
+#	This file is part of x86 plug-in for OTAWA.
+#	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+#
+#	OTAWA is free software; you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation; either version 2 of the License, or
+#	(at your option) any later version.
+#
+#	OTAWA is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with OTAWA; if not, write to the Free Software
+#	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+#
+# Built freestanding with -m32 -nostdlib -static: the checked look-ups are
+# made relatively to these symbols (see test_decoder.cpp).
+
+	.text
+	.globl	_start
+	.type	_start, @function
+_start:
+	hlt
+	.size	_start, 1
+
+# outer contains a nested function, inner, in its middle
+	.type	outer, @function
+outer:
+	.fill	8, 1, 0x90
+	.type	inner, @function
+inner:
+	.fill	8, 1, 0x90
+	.size	inner, 8
+	.fill	16, 1, 0x90
+	.size	outer, 32
+
+# zero-size function followed by 4 bytes outside any function
+	.type	empty, @function
+empty:
+	.size	empty, 0
+	.fill	4, 1, 0x90
+
+# two functions at the same address
+	.type	small, @function
+	.type	big, @function
+small:
+big:
+	.fill	16, 1, 0x90
+	.size	small, 4
+	.size	big, 16
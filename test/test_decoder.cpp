@@ -0,0 +1,775 @@
+/*
+ *	Decoder tests
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <elm/io.h>
+#include <elm/data/Vector.h>
+
+#include <gel++.h>
+#include <gel++/Image.h>
+
+#include <otawa/prog/BlockTable.h>
+#include <otawa/prog/Decoder.h>
+#include <otawa/prog/Inst.h>
+#include <otawa/prog/JumpTable.h>
+#include <otawa/prog/SymbolIndex.h>
+
+#include "../x86.h"
+
+using namespace elm;
+using namespace otawa;
+
+/*
+ * usage:
+ *	test_decoder boundaries OBJDUMP FILE
+ *	test_decoder discover OBJDUMP FILE
+ *	test_decoder prefixes FILE
+ *	test_decoder symbols FILE
+ *	test_decoder switch FILE
+ *
+ * boundaries: the instruction addresses found by the decoder (in full and
+ * in length-only mode) in the .text section of FILE must be the ones
+ * listed by OBJDUMP -d.
+ *
+ * discover: the blocks and the edges found by Decoder::discover() from the
+ * entry point of FILE, with and without its function symbols, must be the
+ * ones of a reference discovery, following the rules of BlockTable, on the
+ * instructions (size, kind and direct target) listed by OBJDUMP -d. The
+ * markers and prologues are given by scanEntries() and the targets of the
+ * jump tables by the decoder. Without the symbols, some blocks must be
+ * found by guess(). The look-ups (find(), indexOf()) must be consistent
+ * with the blocks.
+ *
+ * prefixes: FILE is built from prefixes.s and the instructions decoded
+ * from its entry point must have the expected sizes: the prefix runs
+ * making an instruction longer than 15 bytes are decoded as 1-byte
+ * unknown instructions.
+ *
+ * symbols: FILE is built from symbols.s and the functions found by
+ * SymbolIndex at addresses around its symbols must be the expected ones:
+ * nested, zero-size and equal-address functions are covered, as well as
+ * an empty index.
+ *
+ * switch: FILE is built from switch.c and the indirect jump of sel(),
+ * decoded with decodeRange(), must have a JUMP_TABLE of 8 entries in sel()
+ * and a BRANCH_TARGET for each distinct entry, including the default
+ * case, target of the bound check.
+ *
+ * The exit code is 0 if the test passes, 1 else.
+ */
+
+// sink recording the instructions
+class ListSink: public otawa::Decoder::Sink {
+public:
+	void put(Inst *inst) override { insts.add(inst); }
+	Vector<Inst *> insts;
+};
+
+static otawa::Decoder *make(gel::Image *image, bool lazy) {
+	return otawa::x86::makeDecoder(image, otawa::x86::MODE_PROTECT, false, lazy);
+}
+
+// get the instruction addresses of .text as listed by objdump
+static bool disassemble(cstring objdump, cstring path, Vector<gel::address_t>& addrs) {
+	string cmd = _ << objdump << " -d -z --no-show-raw-insn " << path;
+	FILE *in = popen(cmd.toCString().chars(), "r");
+	if(in == nullptr) {
+		cerr << "ERROR: cannot run " << cmd << io::endl;
+		return false;
+	}
+	char line[1024];
+	bool text = false;
+	while(fgets(line, sizeof(line), in) != nullptr) {
+		string l = line;
+		if(l.startsWith("Disassembly of section "))
+			text = l.startsWith("Disassembly of section .text:");
+		else if(text && l.startsWith(" ")) {
+			char *end;
+			gel::address_t a = strtoull(line, &end, 16);
+			if(end != line && *end == ':')
+				addrs.add(a);
+		}
+	}
+	return pclose(in) == 0 && addrs.count() != 0;
+}
+
+static int boundaries(cstring objdump, cstring path) {
+	Vector<gel::address_t> expected;
+	if(!disassemble(objdump, path, expected)) {
+		cerr << "ERROR: no disassembly for " << path << io::endl;
+		return 1;
+	}
+	auto file = gel::Manager::open(path);
+	auto image = file->make();
+
+	int failed = 0;
+	for(auto lazy: { false, true }) {
+		auto dec = make(image, lazy);
+		ListSink sink;
+		dec->decodeRange(expected[0], expected[expected.count() - 1] + 1, sink);
+		int i = 0;
+		while(i < expected.count() && i < sink.insts.count()
+		&& sink.insts[i]->address().offset() == expected[i])
+			i++;
+		bool ok = i == expected.count() && i == sink.insts.count();
+		cout << (lazy ? "lazy" : "full") << ": " << sink.insts.count() << " instructions, "
+			 << expected.count() << " expected: " << (ok ? "OK" : "FAILED") << io::endl;
+		if(!ok) {
+			cerr << "ERROR: first difference at instruction " << i << ": ";
+			if(i < expected.count())
+				cerr << "expected " << Address(expected[i]);
+			else
+				cerr << "nothing expected";
+			if(i < sink.insts.count())
+				cerr << ", got " << sink.insts[i]->address();
+			else
+				cerr << ", got nothing";
+			cerr << io::endl;
+			failed++;
+		}
+		delete dec;
+	}
+
+	delete image;
+	delete file;
+	return failed == 0 ? 0 : 1;
+}
+
+static int prefixes(cstring path) {
+	static const int sizes[] = { 1, 1, 1, 1, 1, 1, 15, 15, 1, 15, 1 };
+	static const int count = sizeof(sizes) / sizeof(int);
+	auto file = gel::Manager::open(path);
+	auto image = file->make();
+
+	int failed = 0;
+	for(auto lazy: { false, true }) {
+		auto dec = make(image, lazy);
+		Address a = file->entry();
+		for(int i = 0; i < count; i++) {
+			Inst *inst = dec->decode(a);
+			if(inst == nullptr || int(inst->size()) != sizes[i]) {
+				cerr << "ERROR: " << (lazy ? "lazy" : "full") << " decoding, at " << a << ": expected size "
+					 << sizes[i] << ", got " << (inst == nullptr ? 0 : int(inst->size())) << io::endl;
+				failed++;
+				break;
+			}
+			a = inst->topAddress();
+		}
+		delete dec;
+	}
+
+	delete image;
+	delete file;
+	return failed == 0 ? 0 : 1;
+}
+
+// look-up of the symbols test: the function containing the address of
+// a symbol plus an offset must be fun (null for none)
+typedef struct probe_t {
+	const char *sym;
+	int offset;
+	const char *fun;
+} probe_t;
+
+static int symbols(cstring path) {
+	static const probe_t probes[] = {
+		{ "_start",	0,	"_start" },
+		{ "outer",	0,	"outer" },
+		{ "outer",	7,	"outer" },
+		{ "inner",	0,	"inner" },
+		{ "inner",	7,	"inner" },
+		{ "inner",	8,	"outer" },		// after the nested function
+		{ "outer",	31,	"outer" },
+		{ "empty",	0,	"empty" },		// zero-size function
+		{ "empty",	1,	nullptr },
+		{ "empty",	3,	nullptr },
+		{ "small",	0,	"big" },		// the biggest of the same address
+		{ "small",	4,	"big" },
+		{ "big",	15,	"big" },
+		{ "big",	16,	nullptr }
+	};
+	int failed = 0;
+
+	// empty index
+	SymbolIndex none;
+	none.build();
+	if(none.function(0) != nullptr || none.find("outer") != nullptr) {
+		cerr << "ERROR: symbol found in an empty index" << io::endl;
+		failed++;
+	}
+
+	// look-ups
+	auto file = gel::Manager::open(path);
+	SymbolIndex index;
+	auto& st = file->symbols();
+	for(auto s: st)
+		index.add(nullptr, s);
+	index.build();
+	for(const auto& p: probes) {
+		auto s = index.find(p.sym);
+		if(s == nullptr) {
+			cerr << "ERROR: no symbol " << p.sym << io::endl;
+			failed++;
+			continue;
+		}
+		auto f = index.function(s->address() + p.offset);
+		if(p.fun == nullptr ? f != nullptr : f == nullptr || f->name() != cstring(p.fun)) {
+			cerr << "ERROR: at " << p.sym << " + " << p.offset << ": expected "
+				 << (p.fun == nullptr ? "nothing" : p.fun) << ", got "
+				 << (f == nullptr ? cstring("nothing") : f->name()) << io::endl;
+			failed++;
+		}
+	}
+	auto s = index.find("_start");
+	if(s != nullptr && index.function(s->address() - 1) != nullptr) {
+		cerr << "ERROR: function found before _start" << io::endl;
+		failed++;
+	}
+	if(index.find("missing") != nullptr) {
+		cerr << "ERROR: unknown symbol found" << io::endl;
+		failed++;
+	}
+	cout << "symbols: " << (failed == 0 ? "OK" : "FAILED") << io::endl;
+
+	delete file;
+	return failed == 0 ? 0 : 1;
+}
+
+// find a function symbol of a gel file
+static bool findFunction(gel::File *file, cstring name, gel::address_t& addr, t::uint32& size) {
+	auto& st = file->symbols();
+	for(auto s: st)
+		if(s->type() == gel::Symbol::FUNC && s->name() == name) {
+			addr = s->value();
+			size = s->size();
+			return true;
+		}
+	return false;
+}
+
+static int switches(cstring path) {
+	auto file = gel::Manager::open(path);
+	auto image = file->make();
+	gel::address_t sel;
+	t::uint32 size;
+	if(!findFunction(file, "sel", sel, size)) {
+		cerr << "ERROR: no function sel in " << path << io::endl;
+		return 1;
+	}
+
+	int failed = 0;
+	for(auto lazy: { false, true }) {
+		auto dec = make(image, lazy);
+		ListSink sink;
+		dec->decodeRange(sel, sel + size, sink);
+
+		// find the bound check and the indirect jump
+		Inst *check = nullptr, *jump = nullptr;
+		for(auto i: sink.insts)
+			if(i->isControl() && i->isIndirect() && !i->isCall() && !i->isReturn()) {
+				jump = i;
+				break;
+			}
+			else if(i->isControl() && i->isConditional())
+				check = i;
+		if(jump == nullptr || check == nullptr || check->target() == nullptr) {
+			cerr << "ERROR: no bound check and indirect jump in sel" << io::endl;
+			failed++;
+			delete dec;
+			continue;
+		}
+
+		// check the table
+		JumpTable *jt = JUMP_TABLE(jump);
+		int errors = 0;
+		if(jt == nullptr || jt->count() != 8) {
+			cerr << "ERROR: at " << jump->address() << ": expected a table of 8 entries" << io::endl;
+			errors++;
+		}
+		else {
+			Vector<gel::address_t> targets;
+			for(auto t: jt->targets()) {
+				if(t < sel || t >= sel + size) {
+					cerr << "ERROR: table entry " << Address(t) << " out of sel" << io::endl;
+					errors++;
+				}
+				if(!targets.contains(t))
+					targets.add(t);
+			}
+			Vector<gel::address_t> branches;
+			for(Identifier<Address>::Getter t(jump, BRANCH_TARGET); t(); t++) {
+				if(!targets.contains((*t).offset())) {
+					cerr << "ERROR: branch target " << *t << " not in the table" << io::endl;
+					errors++;
+				}
+				if(!branches.contains((*t).offset()))
+					branches.add((*t).offset());
+			}
+			if(branches.count() != targets.count()) {
+				cerr << "ERROR: " << branches.count() << " branch targets for "
+					 << targets.count() << " table entries" << io::endl;
+				errors++;
+			}
+			if(!branches.contains(check->target()->address().offset())) {
+				cerr << "ERROR: the default case is not a branch target" << io::endl;
+				errors++;
+			}
+		}
+		cout << (lazy ? "lazy" : "full") << ": " << (errors == 0 ? "OK" : "FAILED") << io::endl;
+		failed += errors;
+		delete dec;
+	}
+
+	delete image;
+	delete file;
+	return failed == 0 ? 0 : 1;
+}
+
+// instruction listed by objdump
+typedef struct listed_t {
+	gel::address_t addr, target;
+	t::uint32 size;
+	Inst::kind_t kind;
+	bool branch, bad;
+} listed_t;
+
+// test if a word is in a null-terminated list
+static bool among(const char *w, const char *const list[]) {
+	for(int i = 0; list[i] != nullptr; i++)
+		if(strcmp(w, list[i]) == 0)
+			return true;
+	return false;
+}
+
+// get the kind and the direct target of an instruction from its objdump text
+static void classify(const char *text, listed_t& l) {
+	static const char *const prefixes[] = { "notrack", "bnd", "lock", "rep", "repz", "repnz", "repe", "repne",
+		"data16", "addr16", "addr32", "cs", "ds", "es", "fs", "gs", "ss", nullptr };
+	static const char *const traps[] = { "int", "int1", "int3", "icebp", "into", "ud0", "ud1", "ud2",
+		"syscall", "sysenter", "bound", nullptr };
+	static const char *const returns[] = { "sysexit", "sysret", "rsm", nullptr };
+	static const char *const calls[] = { "call", "calll", "callw", "lcall", nullptr };
+	static const char *const jumps[] = { "jmp", "jmpl", "jmpw", "ljmp", nullptr };
+	char w[32];
+	int n;
+	do {
+		if(sscanf(text, " %31s%n", w, &n) != 1)
+			return;
+		text += n;
+	} while(among(w, prefixes));
+	while(*text == ' ')
+		text++;
+
+	cstring m = w;
+	if(m == "(bad)")
+		l.bad = true;
+	else if(m.startsWith("ret") || m.startsWith("lret") || m.startsWith("iret") || among(w, returns))
+		l.kind = Inst::IS_CONTROL | Inst::IS_RETURN;
+	else if(among(w, traps))
+		l.kind = Inst::IS_CONTROL | Inst::IS_TRAP;
+	else if(among(w, calls))
+		l.kind = Inst::IS_CONTROL | Inst::IS_CALL;
+	else if(among(w, jumps))
+		l.kind = Inst::IS_CONTROL;
+	else if(m.startsWith("j") || m.startsWith("loop"))
+		l.kind = Inst::IS_CONTROL | Inst::IS_COND;
+	if(l.kind & Inst::IS_CONTROL) {
+		if(*text == '*')
+			l.kind |= Inst::IS_INDIRECT;
+		else if(isxdigit(*text) && m[0] != 'l') {
+			l.branch = true;
+			l.target = strtoull(text, nullptr, 16);
+		}
+	}
+}
+
+// get the instructions of the code sections as listed by objdump
+// (options may restrict the listed addresses)
+static bool list(cstring objdump, cstring path, Vector<listed_t>& insts, string options = "") {
+	string cmd = _ << objdump << " -d -z -w " << options << ' ' << path;
+	FILE *in = popen(cmd.toCString().chars(), "r");
+	if(in == nullptr) {
+		cerr << "ERROR: cannot run " << cmd << io::endl;
+		return false;
+	}
+	char line[1024];
+	while(fgets(line, sizeof(line), in) != nullptr) {
+		char *p;
+		listed_t l = { 0, 0, 0, 0, false, false };
+		l.addr = strtoull(line, &p, 16);
+		if(p == line || *p != ':' || p[1] != '\t')
+			continue;
+		p += 2;
+		while(*p != '\t' && *p != '\n' && *p != '\0') {
+			if(isxdigit(*p)) {
+				l.size++;
+				p += 2;
+			}
+			else
+				p++;
+		}
+		if(*p == '\t') {
+			classify(p + 1, l);
+			insts.add(l);
+		}
+	}
+	if(insts.count() != 0)
+		std::sort(&insts[0], &insts[0] + insts.count(),
+			[](const listed_t& l1, const listed_t& l2) { return l1.addr < l2.addr; });
+	return pclose(in) == 0 && insts.count() != 0;
+}
+
+// sort an address set
+static void normalize(Vector<gel::address_t>& v) {
+	if(v.count() == 0)
+		return;
+	auto p = &v[0];
+	std::sort(p, p + v.count());
+	int n = std::unique(p, p + v.count()) - p;
+	while(v.count() > n)
+		v.pop();
+}
+
+// look for an address in a sorted set
+static bool contains(const Vector<gel::address_t>& v, gel::address_t a) {
+	return v.count() != 0 && std::binary_search(&v[0], &v[0] + v.count(), a);
+}
+
+// jump table target found by the decoder
+typedef struct jump_t {
+	gel::address_t addr, target;
+} jump_t;
+
+// reference discovery on the objdump listing, with the rules of BlockTable;
+// the instructions overlapping the listed ones (jumps over a prefix)
+// are disassembled on demand and appended to the listing
+class Reference {
+public:
+	typedef struct block_t {
+		gel::address_t addr, top;
+		int count;
+		bool entry;
+	} block_t;
+	typedef struct edge_t {
+		int source;
+		gel::address_t target;
+		BlockTable::edge_kind_t kind;
+	} edge_t;
+
+	Reference(cstring objdump, cstring path, const Vector<listed_t>& insts, const Vector<jump_t>& jumps)
+		: _objdump(objdump), _path(path), _insts(insts), _listed(insts.count()), _jumps(jumps) {
+		for(int i = 0; i < insts.count(); i++)
+			_visited.add(false);
+	}
+
+	void entry(gel::address_t a) {
+		_entries.add(a);
+		_leaders.add(a);
+		_todo.add(a);
+	}
+
+	void explore() {
+		while(_todo.count() != 0) {
+			int i = find(_todo.pop());
+			while(i >= 0 && !_visited[i] && !_insts[i].bad) {
+				const listed_t l = _insts[i];
+				_visited[i] = true;
+				_recs.add(i);
+				if(l.branch) {
+					if(l.kind & Inst::IS_CALL)
+						entry(l.target);
+					else {
+						_leaders.add(l.target);
+						_todo.add(l.target);
+					}
+				}
+				for(auto j: _jumps)
+					if(j.addr == l.addr) {
+						_leaders.add(j.target);
+						_todo.add(j.target);
+					}
+				if(!falls(l.kind))
+					break;
+				i = find(l.addr + l.size);
+			}
+		}
+	}
+
+	void guess(const Vector<gel::address_t>& candidates) {
+		sortRecs();
+		for(auto a: candidates) {
+			int l = 0, h = _recs.count();
+			while(l < h) {
+				int m = (l + h) / 2;
+				if(_insts[_recs[m]].addr <= a)
+					l = m + 1;
+				else
+					h = m;
+			}
+			if(l == 0 || a >= _insts[_recs[l - 1]].addr + _insts[_recs[l - 1]].size) {
+				entry(a);
+				guessed++;
+			}
+		}
+	}
+
+	void build() {
+		sortRecs();
+		normalize(_leaders);
+		normalize(_entries);
+		Vector<int> last;
+		for(int i = 0; i < _recs.count(); i++) {
+			const listed_t& l = _insts[_recs[i]];
+			if(i == 0 || _insts[_recs[i - 1]].addr + _insts[_recs[i - 1]].size != l.addr
+			|| (_insts[_recs[i - 1]].kind & Inst::IS_CONTROL) || contains(_leaders, l.addr)) {
+				blocks.add({ l.addr, l.addr, 0, contains(_entries, l.addr) });
+				last.add(0);
+			}
+			blocks.top().top = l.addr + l.size;
+			blocks.top().count++;
+			last.top() = _recs[i];
+		}
+		for(int i = 0; i < blocks.count(); i++) {
+			const listed_t& l = _insts[last[i]];
+			if(l.branch)
+				edges.add({ i, l.target, l.kind & Inst::IS_CALL ? BlockTable::CALL : BlockTable::TAKEN });
+			for(auto j: _jumps)
+				if(j.addr == l.addr)
+					edges.add({ i, j.target, BlockTable::TAKEN });
+			if(falls(l.kind))
+				edges.add({ i, blocks[i].top, BlockTable::FALL });
+		}
+	}
+
+	Vector<block_t> blocks;
+	Vector<edge_t> edges;
+	int guessed = 0;
+
+private:
+
+	static bool falls(Inst::kind_t kind) {
+		if(!(kind & Inst::IS_CONTROL))
+			return true;
+		if(kind & Inst::IS_RETURN)
+			return false;
+		return (kind & (Inst::IS_COND | Inst::IS_CALL | Inst::IS_TRAP)) != 0;
+	}
+
+	// find the instruction at an address (-1 if none)
+	int find(gel::address_t a) {
+		int l = 0, h = _listed;
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(_insts[m].addr < a)
+				l = m + 1;
+			else
+				h = m;
+		}
+		if(l < _listed && _insts[l].addr == a)
+			return l;
+		for(int i = _listed; i < _insts.count(); i++)
+			if(_insts[i].addr == a)
+				return i;
+		Vector<listed_t> one;
+		listed_t r = { a, 0, 0, 0, false, true };
+		if(list(_objdump, _path, one, _ << "--start-address=" << a << " --stop-address=" << (a + 16)) && one[0].addr == a)
+			r = one[0];
+		_insts.add(r);
+		_visited.add(false);
+		return _insts.count() - 1;
+	}
+
+	void sortRecs() {
+		if(_recs.count() != 0)
+			std::sort(&_recs[0], &_recs[0] + _recs.count(),
+				[this](int i, int j) { return _insts[i].addr < _insts[j].addr; });
+	}
+
+	cstring _objdump, _path;
+	Vector<listed_t> _insts;
+	int _listed;
+	const Vector<jump_t>& _jumps;
+	Vector<bool> _visited;
+	Vector<int> _recs;
+	Vector<gel::address_t> _leaders, _entries, _todo;
+};
+
+static int discovery(cstring objdump, cstring path) {
+	Vector<listed_t> insts;
+	if(!list(objdump, path, insts)) {
+		cerr << "ERROR: no disassembly for " << path << io::endl;
+		return 1;
+	}
+	auto file = gel::Manager::open(path);
+	auto image = file->make();
+	Vector<gel::address_t> start, funs;
+	start.add(file->entry());
+	funs.add(file->entry());
+	auto& st = file->symbols();
+	for(auto s: st)
+		if(s->type() == gel::Symbol::FUNC)
+			funs.add(s->value());
+
+	// from the entry point only, the functions called indirectly are found
+	// by the markers and the prologues
+	int failed = 0;
+	for(auto lazy: { false, true })
+	for(auto syms: { true, false }) {
+		const Vector<gel::address_t>& entries = syms ? funs : start;
+		cstring label = lazy ? (syms ? "lazy, symbols" : "lazy, entry") : (syms ? "full, symbols" : "full, entry");
+		auto dec = make(image, lazy);
+		BlockTable table(dec->segments());
+		dec->discover(entries, table);
+		int errors = 0;
+
+		// the targets of the jump tables are only known by the decoder
+		Vector<jump_t> jumps;
+		for(int i = 0; i < table.count(); i++) {
+			const BlockTable::Block& b = table[i];
+			Inst *last = table.inst(b, b.count() - 1);
+			if((last->kind() & (Inst::IS_CONTROL | Inst::IS_INDIRECT | Inst::IS_CALL)) != (Inst::IS_CONTROL | Inst::IS_INDIRECT))
+				continue;
+			for(int j = 0; j < b.edgeCount(); j++)
+				if(table.edge(b, j).kind() == BlockTable::TAKEN && table.edge(b, j).isResolved())
+					jumps.add({ last->address().offset(), table[table.edge(b, j).target()].address() });
+		}
+
+		// reference discovery from the same entries
+		Vector<gel::address_t> markers, prologues;
+		for(int i = 0; i < dec->segments().count(); i++) {
+			const SegmentIndex::Entry& e = dec->segments()[i];
+			if(e.segment()->isExecutable())
+				x86::scanEntries(e.bytes(), e.available(), e.base(), x86::MODE_PROTECT, &markers, &prologues);
+		}
+		Reference ref(objdump, path, insts, jumps);
+		for(auto e: entries)
+			ref.entry(e);
+		for(auto m: markers)
+			ref.entry(m);
+		ref.explore();
+		ref.guess(prologues);
+		ref.explore();
+		ref.build();
+
+		// compare the counts
+		int counts[3] = { 0, 0, 0 }, ref_counts[3] = { 0, 0, 0 };
+		for(int i = 0; i < table.count(); i++)
+			for(int j = 0; j < table[i].edgeCount(); j++)
+				counts[table.edge(table[i], j).kind()]++;
+		for(const auto& e: ref.edges)
+			ref_counts[e.kind]++;
+		cout << label << ": " << table.count() << " blocks, " << table.edgeCount() << " edges ("
+			 << counts[BlockTable::FALL] << " fall, " << counts[BlockTable::TAKEN] << " taken, "
+			 << counts[BlockTable::CALL] << " call), " << ref.guessed << " guessed entries" << io::endl;
+		if(table.count() != ref.blocks.count() || table.edgeCount() != ref.edges.count()
+		|| counts[0] != ref_counts[0] || counts[1] != ref_counts[1] || counts[2] != ref_counts[2]) {
+			cerr << "ERROR: expected " << ref.blocks.count() << " blocks, " << ref.edges.count() << " edges ("
+				 << ref_counts[BlockTable::FALL] << " fall, " << ref_counts[BlockTable::TAKEN] << " taken, "
+				 << ref_counts[BlockTable::CALL] << " call)" << io::endl;
+			errors++;
+		}
+		if(!syms && ref.guessed == 0) {
+			cerr << "ERROR: no block found by guess()" << io::endl;
+			errors++;
+		}
+
+		// compare the blocks and their edges
+		for(int i = 0, k = 0; errors == 0 && i < table.count(); i++) {
+			const BlockTable::Block& b = table[i];
+			const Reference::block_t& r = ref.blocks[i];
+			if(b.address() != r.addr || b.top() != r.top || b.count() != r.count || b.isEntry() != r.entry) {
+				cerr << "ERROR: block " << i << " at " << Address(b.address()) << " (" << b.count()
+					 << " instructions), expected " << Address(r.addr) << " (" << r.count << " instructions)" << io::endl;
+				errors++;
+			}
+			for(int j = 0; j < b.edgeCount(); j++, k++) {
+				const BlockTable::Edge& e = table.edge(b, j);
+				const Reference::edge_t& re = ref.edges[k];
+				if(e.source() != t::uint32(i) || re.source != i || e.kind() != re.kind
+				|| e.target() != table.indexOf(re.target)) {
+					cerr << "ERROR: edge " << j << " of block " << Address(b.address()) << " differs" << io::endl;
+					errors++;
+				}
+			}
+
+			// look-ups (a block may overlap the next one when a jump skips a prefix)
+			const BlockTable::Block *n = i + 1 < table.count() ? &table[i + 1] : nullptr;
+			gel::address_t next = n == nullptr ? b.top() + 1 : n->address();
+			if(table.indexOf(b.address()) != t::uint32(i) || table.find(b.address()) != &b
+			|| (next > b.address() + 1 && table.indexOf(b.address() + 1) != BlockTable::NO_BLOCK)
+			|| (next >= b.top() && table.find(b.top() - 1) != &b)
+			|| (next == b.top() && table.find(b.top()) != n)
+			|| (next > b.top() && (table.find(b.top()) != nullptr || table.indexOf(b.top()) != BlockTable::NO_BLOCK))) {
+				cerr << "ERROR: bad look-up of block " << Address(b.address()) << io::endl;
+				errors++;
+			}
+		}
+
+		cout << label << ": " << (errors == 0 ? "OK" : "FAILED") << io::endl;
+		failed += errors;
+		delete dec;
+	}
+
+	delete image;
+	delete file;
+	return failed == 0 ? 0 : 1;
+}
+
+static void usage() {
+	cerr << "usage: test_decoder boundaries OBJDUMP FILE\n"
+		 << "       test_decoder discover OBJDUMP FILE\n"
+		 << "       test_decoder prefixes FILE\n"
+		 << "       test_decoder symbols FILE\n"
+		 << "       test_decoder switch FILE\n";
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	if(argc < 2)
+		usage();
+	string test = argv[1];
+	try {
+		if(test == "boundaries" && argc == 4)
+			return boundaries(argv[2], argv[3]);
+		else if(test == "discover" && argc == 4)
+			return discovery(argv[2], argv[3]);
+		else if(test == "prefixes" && argc == 3)
+			return prefixes(argv[2]);
+		else if(test == "symbols" && argc == 3)
+			return symbols(argv[2]);
+		else if(test == "switch" && argc == 3)
+			return switches(argv[2]);
+		else
+			usage();
+	}
+	catch(gel::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+	}
+	catch(otawa::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+	}
+	return 1;
+}
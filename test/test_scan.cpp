@@ -0,0 +1,163 @@
+/*
+ *	Entry scan tests
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+
+#include <elm/io.h>
+
+// the scan functions are static
+#include "../x86_scan.cpp"
+
+using namespace elm;
+using namespace otawa;
+using namespace otawa::x86;
+
+/*
+ * usage:
+ *	test_scan
+ *
+ * The SSE2 and AVX2 scans (when supported by the host), completed by the
+ * scalar scan of the tail, must find the same markers and prologues as
+ * the scalar scan alone. The buffers are random bytes, biased towards the
+ * pattern bytes, where patterns are planted across the 16 and 32-byte
+ * steps, in the last bytes and as a marker followed by a prologue.
+ *
+ * The exit code is 0 if the test passes, 1 else.
+ */
+
+// xorshift generator (reproducible runs)
+static t::uint32 seed = 2463534242u;
+static t::uint32 rand32() {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+// scan function completed by the scalar scan
+typedef t::uint32 (*scan_t)(const t::uint8 *p, t::uint32 n, Matches& m);
+
+static t::uint32 scanNone(const t::uint8 *p, t::uint32 n, Matches& m) {
+	return 0;
+}
+
+// scan a buffer
+static void scan(scan_t f, const t::uint8 *p, t::uint32 n, const pattern_t *pats,
+Vector<gel::address_t>& markers, Vector<gel::address_t>& prologues) {
+	Matches m(0x1000, pats, &markers, &prologues);
+	scanScalar(p, n, f(p, n, m), m);
+}
+
+// plant a pattern at offset o if it fits
+static void plant(t::uint8 *p, t::uint32 n, t::uint32 o, const pattern_t& pat) {
+	if(o + pat.len <= n)
+		memcpy(p + o, pat.bytes, pat.len);
+}
+
+// fill a buffer with random bytes and planted patterns, return the offset
+// of the marker followed by a prologue (n if none)
+static t::uint32 fill(t::uint8 *p, t::uint32 n, const pattern_t *pats) {
+	static const t::uint8 bytes[] = { 0xf3, 0x0f, 0x1e, 0xfa, 0xfb, 0x55, 0x48, 0x89, 0x8b, 0xe5, 0xec };
+	for(t::uint32 i = 0; i < n; i++)
+		p[i] = rand32() % 2 ? bytes[rand32() % sizeof(bytes)] : t::uint8(rand32());
+	if(n == 0)
+		return n;
+
+	// across the steps and in the tail
+	for(t::uint32 s = 16; s < n; s += 16)
+		plant(p, n, s - 1 - rand32() % 3, pats[rand32() % PATTERN_COUNT]);
+	for(int i = 3; i <= 4; i++)
+		if(n >= t::uint32(i))
+			plant(p, n, n - i, pats[rand32() % PATTERN_COUNT]);
+
+	// marker followed by a prologue
+	const pattern_t& pro = pats[1 + rand32() % 2];
+	if(n < t::uint32(pats[0].len + pro.len))
+		return n;
+	t::uint32 o = rand32() % (n - pats[0].len - pro.len + 1);
+	plant(p, n, o, pats[0]);
+	plant(p, n, o + pats[0].len, pro);
+	return o;
+}
+
+// compare two address lists
+static bool same(const Vector<gel::address_t>& v1, const Vector<gel::address_t>& v2) {
+	if(v1.count() != v2.count())
+		return false;
+	for(int i = 0; i < v1.count(); i++)
+		if(v1[i] != v2[i])
+			return false;
+	return true;
+}
+
+int main() {
+	static const int ROUNDS = 2000, MAX_SIZE = 300;
+	typedef struct {
+		const char *name;
+		scan_t scan;
+		bool supported;
+	} impl_t;
+	static const impl_t impls[] = {
+#		ifdef X86_SCAN_SIMD
+			{ "sse2", scanSSE2, bool(__builtin_cpu_supports("sse2")) },
+			{ "avx2", scanAVX2, bool(__builtin_cpu_supports("avx2")) },
+#		endif
+		{ "none", scanNone, false }
+	};
+	static const pattern_t *modes[] = { PATTERNS32, PATTERNS64 };
+
+	int failed = 0, found = 0;
+	for(int r = 0; r < ROUNDS && failed < 10; r++) {
+		t::uint32 n = rand32() % MAX_SIZE;
+		t::uint8 *p = new t::uint8[n];
+		for(auto pats: modes) {
+			t::uint32 o = fill(p, n, pats);
+			Vector<gel::address_t> markers, prologues;
+			scan(scanNone, p, n, pats, markers, prologues);
+			found += markers.count() + prologues.count();
+			if(o < n && (!markers.contains(0x1000 + o) || prologues.contains(0x1000 + o + pats[0].len))) {
+				cerr << "ERROR: scalar scan of " << n << " bytes (round " << r << "): bad match of the marker at "
+					 << o << " followed by a prologue" << io::endl;
+				failed++;
+			}
+			for(const auto& impl: impls) {
+				if(!impl.supported)
+					continue;
+				Vector<gel::address_t> ms, ps;
+				scan(impl.scan, p, n, pats, ms, ps);
+				if(!same(markers, ms) || !same(prologues, ps)) {
+					cerr << "ERROR: " << impl.name << " scan of " << n << " bytes (round " << r << ", "
+						 << (pats == PATTERNS32 ? "32" : "64") << "-bit): " << ms.count() << " markers, "
+						 << ps.count() << " prologues, expected " << markers.count() << " markers, "
+						 << prologues.count() << " prologues" << io::endl;
+					failed++;
+				}
+			}
+		}
+		delete [] p;
+	}
+
+	for(const auto& impl: impls)
+		if(impl.scan != scanNone)
+			cout << impl.name << ": " << (impl.supported ? "tested" : "not supported") << io::endl;
+	cout << found << " matches: " << (failed == 0 ? "OK" : "FAILED") << io::endl;
+	return failed == 0 ? 0 : 1;
+}
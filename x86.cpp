@@ -24,7 +24,6 @@
 
 #include <otawa/prog/Decoder.h>
 
-#include <Zydis/Zydis.h>
 #include "x86.h"
 
 namespace otawa { namespace x86 {
@@ -60,10 +59,12 @@ Register EDX(Register::Make("EDX").kind(Register::INT).size(32));
 Register CS(Register::Make("CS").kind(Register::ADDR).size(32));
 Register DS(Register::Make("DS").kind(Register::ADDR).size(32));
 Register SS(Register::Make("SS").kind(Register::ADDR).size(32));
-Register ES(Register::Make("DS").kind(Register::ADDR).size(32));
+Register ES(Register::Make("ES").kind(Register::ADDR).size(32));
+Register FS(Register::Make("FS").kind(Register::ADDR).size(32));
+Register GS(Register::Make("GS").kind(Register::ADDR).size(32));
 
 Register SP(Register::Make("SP").kind(Register::ADDR).size(16));
-Register BP(Register::Make("BS").kind(Register::ADDR).size(16));
+Register BP(Register::Make("BP").kind(Register::ADDR).size(16));
 Register ESP(Register::Make("ESP").kind(Register::ADDR).size(32));
 Register EBP(Register::Make("EBP").kind(Register::ADDR).size(32));
 Register SI(Register::Make("SI").kind(Register::ADDR).size(16));
@@ -78,6 +79,25 @@ Register EFLAGS(Register::Make("EFLAGS").kind(Register::BITS).size(16));
 Register IP(Register::Make("IP").kind(Register::ADDR).size(16));
 Register EIP(Register::Make("EIP").kind(Register::ADDR).size(32));
 
+// 64-bit (long mode only)
+Register RAX(Register::Make("RAX").kind(Register::INT).size(64));
+Register RBX(Register::Make("RBX").kind(Register::INT).size(64));
+Register RCX(Register::Make("RCX").kind(Register::INT).size(64));
+Register RDX(Register::Make("RDX").kind(Register::INT).size(64));
+Register RSP(Register::Make("RSP").kind(Register::ADDR).size(64));
+Register RBP(Register::Make("RBP").kind(Register::ADDR).size(64));
+Register RSI(Register::Make("RSI").kind(Register::ADDR).size(64));
+Register RDI(Register::Make("RDI").kind(Register::ADDR).size(64));
+Register R8(Register::Make("R8").kind(Register::INT).size(64));
+Register R9(Register::Make("R9").kind(Register::INT).size(64));
+Register R10(Register::Make("R10").kind(Register::INT).size(64));
+Register R11(Register::Make("R11").kind(Register::INT).size(64));
+Register R12(Register::Make("R12").kind(Register::INT).size(64));
+Register R13(Register::Make("R13").kind(Register::INT).size(64));
+Register R14(Register::Make("R14").kind(Register::INT).size(64));
+Register R15(Register::Make("R15").kind(Register::INT).size(64));
+Register RIP(Register::Make("RIP").kind(Register::ADDR).size(64));
+
 // platform definition
 RegBank DATA(RegBank::Make("DATA")
 	.add(EAX).add(EBX).add(ECX).add(EDX)		.add(AX).add(BX).add(CX).add(DX)
@@ -87,7 +107,7 @@ RegBank DATA(RegBank::Make("DATA")
 RegBank ADDRESS(RegBank::Make("ADDRESS")
 	.add(ESP).add(EBP).add(ESI).add(EDI)
 	.add(SP).add(BP).add(SI).add(DI)
-	.add(CS).add(DS).add(SS).add(ES)
+	.add(CS).add(DS).add(SS).add(ES).add(FS).add(GS)
 );
 
 RegBank STATUS(RegBank::Make("INTERN")
@@ -95,240 +115,178 @@ RegBank STATUS(RegBank::Make("INTERN")
 	.add(IP)
 	.add(EIP));
 
+// sub-registers of R8-R15 and SPL, BPL, SIL, DIL are represented by
+// their enclosing register
+RegBank LONG(RegBank::Make("LONG")
+	.add(RAX).add(RBX).add(RCX).add(RDX).add(RSP).add(RBP).add(RSI).add(RDI)
+	.add(R8).add(R9).add(R10).add(R11).add(R12).add(R13).add(R14).add(R15)
+	.add(RIP));
+
+
+// registers by number
+Register *const REGS[R_COUNT] = {
+	&EAX, &EBX, &ECX, &EDX, &AX, &BX, &CX, &DX,
+	&AL, &AH, &BL, &BH, &CL, &CH, &DL, &DH,
+	&ESP, &EBP, &ESI, &EDI, &SP, &BP, &SI, &DI,
+	&CS, &DS, &SS, &ES, &FS, &GS,
+	&EFLAGS, &IP, &EIP,
+	&RAX, &RBX, &RCX, &RDX, &RSP, &RBP, &RSI, &RDI,
+	&R8, &R9, &R10, &R11, &R12, &R13, &R14, &R15, &RIP
+};
 
-// platform definition
-const RegBank *banks[] = { &DATA, &ADDRESS, &STATUS };
-Platform::Platform(): hard::Platform(hard::Platform::Identification("x86")) {
-	setBanks(banks_t(3, otawa::x86::banks));
+// platform definition (the long mode adds the LONG bank)
+const RegBank *banks[] = { &DATA, &ADDRESS, &STATUS, &LONG };
+Platform::Platform(mode_t mode)
+: hard::Platform(hard::Platform::Identification(mode == MODE_LONG ? "x86_64" : "x86")) {
+	setBanks(banks_t(mode == MODE_LONG ? 4 : 3, otawa::x86::banks));
+	for(int i = 0; i < (mode == MODE_LONG ? R_COUNT : R_COUNT32); i++)
+		ASSERT(REGS[i]->platformNumber() == i);
 }
 
-#if 0
-// Decoder class
-class Decoder: public otawa::Decoder {
-public:
+/**
+ * Get the x86 platform of a mode. It is immutable and shared by all decoders
+ * of the process: it is built at the first call and never released.
+ * @param mode	Processor mode (MODE_LONG for x86-64, 32-bit platform else).
+ * @return		x86 platform.
+ */
+Platform *Platform::shared(mode_t mode) {
+	static Platform pf(MODE_PROTECT), pf64(MODE_LONG);
+	return mode == MODE_LONG ? &pf64 : &pf;
+}
 
-	class BaseInst: public Inst {
-	public:
-		BaseInst(Decoder& decoder, Address addr, t::size size, kind_t kind)
-			: dec(decoder), a(addr.offset()), s(size), k(kind) { }
-		Address address() const override { return a; }
-		t::uint32 size() const override { return s; }
-		kind_t kind() override { return k; }
-
-		void dump(io::Output &out) override {
-			//cerr << io::hex(a) << ':' << s << io::endl;
-			auto r = dec.decodeRaw(a);
-			ASSERT(r);
-			char buffer[256];
-			ZydisFormatterFormatInstruction(&dec.zform, &dec.zi, buffer, sizeof(buffer), a);
-			out << buffer;
-		}
+/**
+ * @class Timed
+ * Interface of the x86 instructions providing their timing for a
+ * microarchitecture profile. The timings come from constant tables indexed
+ * by profile and by instruction form so that a query costs an indirection.
+ * They describe the register form of the instruction: the memory accesses
+ * are left to the memory hierarchy analyses.
+ */
 
-	protected:
-		Decoder &dec;
-		t::uint32 a;
-		t::uint32 s;
-		kind_t k;
-	};
+///
+Timed::~Timed() {
+}
 
-	class Branch: public BaseInst {
-	public:
-		Branch(Decoder& decoder, Address addr, t::size size, kind_t kind, t::int32 off): BaseInst(decoder, addr, size, kind), o(off), t(nullptr) { }
-		Inst *target() override {
-			if(getKind().isIndirect())
-				return nullptr;
-			else if(t == nullptr)
-				t = dec.decode(a + s + o);
-			return t;
-		}
-	private:
-		t::int32 o;
-		Inst *t;
-	};
+/**
+ * @fn const timing_t& Timed::timing(profile_t profile) const;
+ * Get the timing of the instruction.
+ * @param profile	Microarchitecture profile (less than PROFILE_COUNT).
+ * @return			Instruction timing.
+ */
 
-	Decoder(gel::Image *i): otawa::Decoder(i) {
-		ZydisDecoderInit(&zdec, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_ADDRESS_WIDTH_32);
-		ZydisFormatterInit(&zform, ZYDIS_FORMATTER_STYLE_INTEL);
-	}
+/**
+ * @fn Timed *Timed::of(otawa::Inst *inst);
+ * Get the timing interface of an instruction.
+ * @param inst	Instruction.
+ * @return		Timing interface or null if the instruction does not provide it.
+ */
 
-	Inst *decode(gel::address_t a) override {
-		if(!decodeRaw(a))
-			return nullptr;
-
-		// compute kind
-		Inst *inst = nullptr;
-		Inst::kind_t k = 0;
-		switch(zi.mnemonic) {
-
-		// relative branchers
-		// target = topAddress() + operands[0].imm
-		case ZYDIS_MNEMONIC_JMP:
-			k = Inst::IS_CONTROL;
-			goto branch;
-		case ZYDIS_MNEMONIC_JB:		// ULT
-		case ZYDIS_MNEMONIC_JBE:	// ULE
-		case ZYDIS_MNEMONIC_JCXZ:	// CX = 0
-		case ZYDIS_MNEMONIC_JECXZ:	// ???
-		case ZYDIS_MNEMONIC_JKNZD:	// ???
-		case ZYDIS_MNEMONIC_JKZD:	// ???
-		case ZYDIS_MNEMONIC_JL:		// LT
-		case ZYDIS_MNEMONIC_JLE:	// LE
-		case ZYDIS_MNEMONIC_JNB:	// UGE
-		case ZYDIS_MNEMONIC_JNBE:	// UGT
-		case ZYDIS_MNEMONIC_JNL:	// GE
-		case ZYDIS_MNEMONIC_JNLE:	// GT
-		case ZYDIS_MNEMONIC_JNO:	// not overflow
-		case ZYDIS_MNEMONIC_JNP:	// parity odd
-		case ZYDIS_MNEMONIC_JNS:	// positive
-		case ZYDIS_MNEMONIC_JNZ:	// NE
-		case ZYDIS_MNEMONIC_JO:		// overflow
-		case ZYDIS_MNEMONIC_JP:		// parity
-		case ZYDIS_MNEMONIC_JRCXZ:	// ???
-		case ZYDIS_MNEMONIC_JS:		// negative
-		case ZYDIS_MNEMONIC_JZ:		// EQ
-			k = Inst::IS_CONTROL | Inst::IS_COND;
-			goto branch;
-
-		case ZYDIS_MNEMONIC_RET:
-			k = Inst::IS_RETURN | Inst::IS_CONTROL;
-			goto normal;
-
-		branch:
-			if(zi.operands[0].type != ZYDIS_OPERAND_TYPE_IMMEDIATE)
-				inst = new Branch(*this, a, zi.length, k | Inst::IS_INDIRECT, 0);
-			else
-				inst = new Branch(*this, a, zi.length, k, zi.operands[0].imm.value.s);
-			break;
+/**
+ * @class Stats
+ * Statistics of an x86 decoder, only collected if DECODE_STATS is set:
+ * decoded instructions and decoding time, unknown opcodes, prefixes and
+ * segment misses of the decoding cursor. Each decoding thread counts in
+ * its own Stats that are added at the end.
+ */
 
+///
+Stats::Stats(): insts(0), time(0), seg_misses(0), unknowns(0) {
+	for(auto& p: prefixes)
+		p = 0;
+	for(auto& o: opcodes)
+		o = 0;
+}
+
+/**
+ * Record an unknown instruction.
+ * @param p		Instruction bytes.
+ * @param e		End of the available bytes.
+ * @param mode	Processor mode.
+ */
+void Stats::unknown(const t::uint8 *p, const t::uint8 *e, mode_t mode) {
+	unknowns++;
+	while(p < e) {
+		switch(*p) {
+		case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65:
+		case 0x66: case 0x67: case 0xf0: case 0xf2: case 0xf3:
+			p++;
+			continue;
 		default:
-		normal:
-			inst = new BaseInst(*this, a, zi.length, k);
+			if(mode == MODE_LONG && (*p & 0xf0) == 0x40) {
+				p++;
+				continue;
+			}
 			break;
 		}
-
-		// dump operands (for debugging)
-#		if 0
-		cerr << "DEBUG: instr @" << io::hex(a) << ": " << static_cast<otawa::Inst *>(inst) << io::endl;
-		for(int i = 0; i < zi.operand_count; i++) {
-			cerr << "DEBUG: operand " << i << " (" << int(zi.operands[i].type) << "): ";
-			switch(zi.operands[i].type) {
-			case ZYDIS_OPERAND_TYPE_REGISTER: {
-					auto r = decodeReg(zi.operands[i].reg.value);
-					if(r != nullptr)
-						cerr << r->name();
-					cerr << " (" << int(zi.operands[i].reg.value) << ")";
-				}
-				break;
-			case ZYDIS_OPERAND_TYPE_MEMORY: {
-					cerr << "[";
-					auto r = decodeReg(zi.operands[i].mem.segment);
-					if(r != nullptr)
-						cerr << r->name() << ":";
-					else
-						cerr << int(zi.operands[i].mem.segment) << ":";
-					r = decodeReg(zi.operands[i].mem.base);
-					if(r != nullptr)
-						cerr << r->name();
-					else
-						cerr << int(zi.operands[i].mem.base);
-					if(zi.operands[i].mem.index != ZYDIS_REGISTER_NONE) {
-						r = decodeReg(zi.operands[i].mem.index);
-						if(r != nullptr)
-							cerr << " + " << r->name();
-						else
-							cerr << " + " << int(zi.operands[i].mem.index);
-						if(zi.operands[i].mem.scale != 0)
-							cerr << "*" << zi.operands[i].mem.scale;
-					}
-					if(zi.operands[i].mem.disp.value != 0)
-						cerr << " + " << zi.operands[i].mem.disp.value;
-					cerr << "]";
-				}
-				break;
-			case ZYDIS_OPERAND_TYPE_POINTER:
-				break;
-			case ZYDIS_OPERAND_TYPE_IMMEDIATE:
-				if(zi.operands[i].imm.is_signed)
-					cerr << io::hex(zi.operands[i].imm.value.s);
-				else
-					cerr << io::hex(zi.operands[i].imm.value.u);
-				break;
-			default:
-				break;
-			}
-			switch(zi.operands[i].visibility) {
-			case ZYDIS_OPERAND_VISIBILITY_EXPLICIT: cerr << " +"; break;
-			case ZYDIS_OPERAND_VISIBILITY_IMPLICIT: cerr << " ~"; break;
-			case ZYDIS_OPERAND_VISIBILITY_HIDDEN:   cerr << " -"; break;
-			default:								cerr << " ?"; break;
-			}
-			cerr << io::endl;
+		break;
+	}
+	if(p >= e)
+		return;
+	int m = 0;
+	if(*p == 0x0f && p + 1 < e) {
+		p++;
+		m = 1;
+		if((*p == 0x38 || *p == 0x3a) && p + 1 < e) {
+			m = *p == 0x38 ? 2 : 3;
+			p++;
 		}
-		cerr << io::endl;
-#		endif
-
-		return inst;
 	}
+	opcodes[m * 256 + *p]++;
+}
 
-	t::size instSize() const override { return 1; }
-	hard::Platform *platform() const override { return new Platform(); }
-
-private:
-
-	bool decodeRaw(t::uint32 a) {
-		auto seg = image()->at(a);
-		if(seg == nullptr)
-			return false;
-		auto buf = seg->buffer();
-		auto r = ZydisDecoderDecodeBuffer(
-			&zdec,
-			buf.at(a - seg->baseAddress()),
-			seg->baseAddress() + seg->size() - a,
-			&zi);
-		return ZYAN_SUCCESS(r);
-	}
+/**
+ * Add the counters of other statistics.
+ * @param s		Added statistics.
+ */
+void Stats::add(const Stats& s) {
+	insts += s.insts;
+	time += s.time;
+	seg_misses += s.seg_misses;
+	unknowns += s.unknowns;
+	for(int i = 0; i < PREFIX_COUNT; i++)
+		prefixes[i] += s.prefixes[i];
+	for(int i = 0; i < MAPS * 256; i++)
+		opcodes[i] += s.opcodes[i];
+}
 
-	hard::Register *decodeReg(ZydisRegister r) {
-		switch(r) {
-		case ZYDIS_REGISTER_AL: 	return &AL;
-		case ZYDIS_REGISTER_CL:		return &CL;
-		case ZYDIS_REGISTER_DL:		return &DL;
-		case ZYDIS_REGISTER_BL:		return &BL;
-		case ZYDIS_REGISTER_AH:		return &AH;
-		case ZYDIS_REGISTER_CH:		return &CH;
-		case ZYDIS_REGISTER_DH:		return &DH;
-		case ZYDIS_REGISTER_BH:		return &BH;
-		//case ZYDIS_REGISTER_SPL:	return &SP;
-		//case ZYDIS_REGISTER_BPL:	return &BP;
-		case ZYDIS_REGISTER_AX:		return &AX;
-		case ZYDIS_REGISTER_CX:		return &CX;
-		case ZYDIS_REGISTER_DX:		return &DX;
-		case ZYDIS_REGISTER_BX:		return &BX;
-		case ZYDIS_REGISTER_SP:		return &SP;
-		case ZYDIS_REGISTER_BP:		return &BP;
-		case ZYDIS_REGISTER_SI:		return &SI;
-		case ZYDIS_REGISTER_DI:		return &DI;
-		case ZYDIS_REGISTER_EAX:	return &EAX;
-		case ZYDIS_REGISTER_ECX:	return &ECX;
-		case ZYDIS_REGISTER_EDX:	return &EDX;
-		case ZYDIS_REGISTER_EBX:	return &EBX;
-		case ZYDIS_REGISTER_ESP:	return &ESP;
-		case ZYDIS_REGISTER_EBP:	return &EBP;
-		case ZYDIS_REGISTER_ESI:	return &ESI;
-		case ZYDIS_REGISTER_EDI:	return &EDI;
-		case ZYDIS_REGISTER_EFLAGS:	return &EFLAGS;
-		case ZYDIS_REGISTER_IP:		return &IP;
-		case ZYDIS_REGISTER_EIP:	return &EIP;
-		default:
-			return nullptr;
+/**
+ * Dump the statistics as a JSON object.
+ * @param out		Output stream.
+ * @param engine	Decoder engine name.
+ * @param hits		Decoder cache hits.
+ * @param misses	Decoder cache misses.
+ */
+void Stats::dump(io::Output& out, cstring engine, t::uint64 hits, t::uint64 misses) const {
+	static const char *const prefix_names[PREFIX_COUNT] = {
+		"lock", "rep", "repne", "segment", "opsize", "adsize", "rex"
+	};
+	static const char *const map_names[MAPS] = { "", "0f", "0f38", "0f3a" };
+	static const char digits[] = "0123456789abcdef";
+	out << "{\n";
+	out << "\t\"engine\": \"" << engine << "\",\n";
+	out << "\t\"decoded\": " << insts << ",\n";
+	out << "\t\"unknown\": " << unknowns << ",\n";
+	out << "\t\"unknown_rate\": " << (insts == 0 ? 0. : double(unknowns) / insts) << ",\n";
+	out << "\t\"unknown_opcodes\": {";
+	bool first = true;
+	for(int i = 0; i < MAPS * 256; i++)
+		if(opcodes[i] != 0) {
+			out << (first ? "\n" : ",\n") << "\t\t\"" << map_names[i / 256]
+				<< digits[(i >> 4) & 0xf] << digits[i & 0xf] << "\": " << opcodes[i];
+			first = false;
 		}
-	}
-
-	ZydisDecoder zdec;
-	ZydisFormatter zform;
-	ZydisDecodedInstruction zi;
-};
-#endif
+	out << (first ? "},\n" : "\n\t},\n");
+	out << "\t\"prefixes\": {";
+	for(int i = 0; i < PREFIX_COUNT; i++)
+		out << (i == 0 ? " " : ", ") << '"' << prefix_names[i] << "\": " << prefixes[i];
+	out << " },\n";
+	out << "\t\"segment_misses\": " << seg_misses << ",\n";
+	out << "\t\"cache_hits\": " << hits << ",\n";
+	out << "\t\"cache_misses\": " << misses << ",\n";
+	out << "\t\"cache_hit_ratio\": " << (hits + misses == 0 ? 0. : double(hits) / (hits + misses)) << ",\n";
+	out << "\t\"ns_per_decode\": " << (insts == 0 ? 0. : double(time) / insts) << "\n";
+	out << "}\n";
+}
 
 // Plug-ins defintions
 class Loader: public otawa::DefaultLoader {
@@ -340,11 +298,25 @@ public:
 
 class DecoderPlugin: public otawa::DecoderPlugin {
 public:
+	static const int EM_X86_64 = 62;
+
 	DecoderPlugin(): otawa::DecoderPlugin("x86", OTAWA_DECODER_NAME, OTAWA_DECODER_NAME) {}
 	
 	Decoder *decode(gel::Image *image) override {
 		return makeDecoder(image);
 	}
+
+	Decoder *decode(gel::Image *image, const PropList& props) override {
+		string engine = DECODER_ENGINE(props);
+		mode_t mode = ELF_MACHINE(props) == EM_X86_64 ? MODE_LONG : MODE_PROTECT;
+		bool stats = !DECODE_STATS(props).isEmpty();
+		if(engine.isEmpty() || engine == "x86")
+			return makeDecoder(image, mode, stats, DECODE_LAZY(props));
+		else if(engine == "zydis")
+			return makeZydisDecoder(image, mode, stats);
+		else
+			throw otawa::Exception(_ << "unknown x86 decoder engine: " << engine);
+	}
 };
 
 } }	// otawa::x86
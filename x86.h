@@ -21,7 +21,12 @@
 #ifndef OTAWA_X86_H
 #define OTAWA_X86_H
 
+#include <chrono>
+
+#include <elm/data/Vector.h>
+#include <gel++.h>
 #include <otawa/hard/Register.h>
+#include <otawa/prog/Inst.h>
 
 namespace otawa { namespace x86 {
 
@@ -34,13 +39,98 @@ extern Register EAX, EBX, ECX, EDX;
 extern Register CS, DS, SS, ES, FS, GS;
 extern Register SP, BP, ESP, EBP, SI, DI, ESI, EDI;
 extern Register EFLAGS, IP, EIP;
+extern Register RAX, RBX, RCX, RDX, RSP, RBP, RSI, RDI;
+extern Register R8, R9, R10, R11, R12, R13, R14, R15, RIP;
+
+// processor modes
+typedef enum {
+	MODE_NONE = 0,
+	MODE_REAL = 1,
+	MODE_PROTECT = 2,
+	MODE_LONG = 3
+} mode_t;
+
+// register numbers, in bank order, matching the platform numbers
+typedef enum {
+	R_EAX, R_EBX, R_ECX, R_EDX, R_AX, R_BX, R_CX, R_DX,
+	R_AL, R_AH, R_BL, R_BH, R_CL, R_CH, R_DL, R_DH,
+	R_ESP, R_EBP, R_ESI, R_EDI, R_SP, R_BP, R_SI, R_DI,
+	R_CS, R_DS, R_SS, R_ES, R_FS, R_GS,
+	R_EFLAGS, R_IP, R_EIP,
+	R_RAX, R_RBX, R_RCX, R_RDX, R_RSP, R_RBP, R_RSI, R_RDI,
+	R_R8, R_R9, R_R10, R_R11, R_R12, R_R13, R_R14, R_R15, R_RIP,
+	R_COUNT,
+	R_COUNT32 = R_RAX		// registers of the 32-bit platform
+} reg_num_t;
+extern Register *const REGS[R_COUNT];
 
 class Platform: public hard::Platform {
 public:
-	Platform();
+	static Platform *shared(mode_t mode = MODE_PROTECT);
+private:
+	Platform(mode_t mode);
+};
+
+// microarchitecture profiles of the timing tables
+typedef enum {
+	PROFILE_I386 = 0,		// generic in-order i386
+	PROFILE_ATOM = 1,		// Intel Atom (Bonnell), in-order dual issue
+	PROFILE_COUNT
+} profile_t;
+
+// timing of an instruction (register form, memory accesses excluded)
+typedef struct timing_t {
+	t::uint8 latency;		// cycles from the operands to the result
+	t::uint8 uops;			// micro-operations
+	t::uint8 ports;			// usable execution ports (bit n for port n)
+} timing_t;
+
+class Timed {
+public:
+	virtual ~Timed();
+	virtual const timing_t& timing(profile_t profile) const = 0;
+	static inline Timed *of(otawa::Inst *inst) { return dynamic_cast<Timed *>(inst); }
 };
 
-otawa::Decoder *makeDecoder(gel::Image *i);
+// decoder statistics (see DECODE_STATS)
+class Stats {
+public:
+	typedef enum {
+		LOCK,
+		REP,
+		REPNE,
+		SEGMENT,
+		OPSIZE,
+		ADSIZE,
+		REX,
+		PREFIX_COUNT
+	} prefix_t;
+	static const int MAPS = 4;		// one byte, 0F, 0F 38, 0F 3A
+
+	Stats();
+	inline void decoded(t::uint64 ns) { insts++; time += ns; }
+	inline void prefix(prefix_t p) { prefixes[p]++; }
+	inline void segmentMiss() { seg_misses++; }
+	void unknown(const t::uint8 *p, const t::uint8 *e, mode_t mode);
+	void add(const Stats& s);
+	void dump(io::Output& out, cstring engine, t::uint64 hits, t::uint64 misses) const;
+
+	static inline t::uint64 now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	t::uint64 insts, time, seg_misses, unknowns;
+	t::uint64 prefixes[PREFIX_COUNT];
+	t::uint64 opcodes[MAPS * 256];
+};
+
+void scanEntries(const t::uint8 *p, t::uint32 n, gel::address_t base, mode_t mode,
+	Vector<gel::address_t> *markers, Vector<gel::address_t> *prologues);
+
+otawa::Decoder *makeDecoder(gel::Image *i, mode_t mode = MODE_PROTECT, bool stats = false, bool lazy = false);
+otawa::Decoder *makeZydisDecoder(gel::Image *i, mode_t mode = MODE_PROTECT, bool stats = false);
 
 }}	// otawa::x86
 
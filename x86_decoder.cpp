@@ -19,10 +19,23 @@
  *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <elm/data/Vector.h>
+
 #include <otawa/prog/DefaultLoader.h>
 #include <otawa/hard/Platform.h>
 
+#include <otawa/prog/Arena.h>
+#include <otawa/prog/BlockTable.h>
 #include <otawa/prog/Decoder.h>
+#include <otawa/prog/Inst.h>
+#include <otawa/prog/InstCache.h>
+#include <otawa/prog/JumpTable.h>
+#include <otawa/prog/RegMask.h>
+#include <otawa/sem/inst.h>
 
 #include "x86.h"
 
@@ -76,10 +89,18 @@ namespace otawa { namespace x86 {
  * 	MODRM.mod (7..6) = 0b11 register direct, else register-indirect
  * 	MODRM.reg (5..3) instruction dependent/register num
  * 	MODRM.rm (2..0) direct/indirect register
+ *
+ * SIB (if MODRM.mod != 0b11 and MODRM.rm = 0b100)
+ * 	SIB.scale (7..6) index multiplier (1, 2, 4, 8)
+ * 	SIB.index (5..3) index register (0b100 for none)
+ * 	SIB.base (2..0) base register (0b101 for none if MODRM.mod = 0b00)
  */
 inline t::uint8 modrm_mod(t::uint8 b) { return b >> 6; }
 inline t::uint8 modrm_reg(t::uint8 b) { return (b >> 3) & 0b111; }
 inline t::uint8 modrm_rm(t::uint8 b) { return b & 0b111; }
+inline t::uint8 sib_scale(t::uint8 b) { return b >> 6; }
+inline t::uint8 sib_index(t::uint8 b) { return (b >> 3) & 0b111; }
+inline t::uint8 sib_base(t::uint8 b) { return b & 0b111; }
 
 
 // r8, r/m8: AL, CL, DL, BL, AH, CH, DHn DHn BH, BPL, SPL, DIL, SIL
@@ -87,353 +108,3226 @@ inline t::uint8 modrm_rm(t::uint8 b) { return b & 0b111; }
 // r32, r/m32: EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI
 // r64, r/m64: RAX, RBX, RCX, RDX, RDI, RSI, RBP, RSP
 
-static Register *reg32[] = {
-	&EAX,
-	&ECX,
-	&EDX,
-	&EBX,
-	&ESP,
-	&EBP,
-	&ESI,
-	&EDI
+// register numbers by hardware encoding
+static constexpr t::uint8 reg8[] = { R_AL, R_CL, R_DL, R_BL, R_AH, R_CH, R_DH, R_BH };
+static constexpr t::uint8 reg16[] = { R_AX, R_CX, R_DX, R_BX, R_SP, R_BP, R_SI, R_DI };
+static constexpr t::uint8 reg32[] = { R_EAX, R_ECX, R_EDX, R_EBX, R_ESP, R_EBP, R_ESI, R_EDI };
+static constexpr int sreg[] = { R_ES, R_CS, R_SS, R_DS, R_FS, R_GS, -1, -1 };
+static constexpr t::uint8 reg64[] = {
+	R_RAX, R_RCX, R_RDX, R_RBX, R_RSP, R_RBP, R_RSI, R_RDI,
+	R_R8, R_R9, R_R10, R_R11, R_R12, R_R13, R_R14, R_R15
+};
+
+// names of the long mode registers without platform register
+static const char *const names8[] = {
+	"AL", "CL", "DL", "BL", "SPL", "BPL", "SIL", "DIL",
+	"R8B", "R9B", "R10B", "R11B", "R12B", "R13B", "R14B", "R15B"
+};
+static const char *const names16[] = {
+	"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI",
+	"R8W", "R9W", "R10W", "R11W", "R12W", "R13W", "R14W", "R15W"
 };
+static const char *const names32[] = {
+	"EAX", "ECX", "EDX", "EBX", "ESP", "EBP", "ESI", "EDI",
+	"R8D", "R9D", "R10D", "R11D", "R12D", "R13D", "R14D", "R15D"
+};
+
+
+/**
+ * INSTRUCTION DESCRIPTION
+ *
+ * Each instruction form is described by an inst_t made of its mnemonic,
+ * its kind and the list of its operands. An operand (arg_t) is made of:
+ * 	* its kind -- where it is encoded in the instruction,
+ * 	* its size -- possibly depending on the operand/address size prefixes
+ * 	  and, in long mode, on the REX prefix,
+ * 	* its access -- read and/or written.
+ *
+ * The layout of the instruction (ModR/M presence, immediate sizes) is
+ * computed at compile time from the operands and the opcode maps are
+ * generated from the descriptors: decoding an instruction is a walk
+ * in the maps and no instruction-specific code is needed.
+ *
+ * Instructions not supported by OTAWA (x87, MMX/SSE, VEX/EVEX, most
+ * of system instructions) are decoded by opaque descriptors that
+ * only provide the correct size.
+ */
+
+// operand kinds
+typedef enum {
+	A_NONE = 0,
+	A_REG,		// general register in ModR/M reg field
+	A_RM,		// general register or memory in ModR/M r/m field
+	A_MEM,		// memory in ModR/M r/m field
+	A_RRM,		// general register in ModR/M r/m field whatever the mod field
+	A_OREG,		// general register in the 3 lower bits of the opcode
+	A_ACC,		// accumulator (AL, AX, EAX)
+	A_CL,		// CL register
+	A_DX,		// DX register (I/O port)
+	A_SREG,		// segment register in ModR/M reg field
+	A_OSREG,	// segment register in bits 5..3 of the opcode
+	A_CREG,		// control register in ModR/M reg field
+	A_DREG,		// debug register in ModR/M reg field
+	A_IMM,		// signed immediate
+	A_UIMM,		// unsigned immediate
+	A_ONE,		// constant 1
+	A_REL,		// offset relative to the next instruction
+	A_MOFFS,	// memory at an absolute offset
+	A_PTR,		// far pointer (selector:offset)
+	A_SRC,		// string source DS:[ESI]
+	A_DST,		// string destination ES:[EDI]
+	A_XRM,		// ModR/M of an opaque instruction
+	A_XIB		// 8-bit immediate of an opaque instruction
+} arg_kind_t;
 
+// operand sizes
 typedef enum {
-	R32_R,	// 32-bit register (read)
-	R32_W,	// 32-bit register (written)
-	SIMM,	// signed immediate
-	UIMM,	// unisgned immediate
-	IPREL	// offset on the PC
-} arg_type_t;
+	S_NONE = 0,
+	S_8,
+	S_16,
+	S_32,
+	S_64,
+	S_V,		// 16- or 32-bit according to operand-size prefix (64-bit with REX.W)
+	S_V64,		// as S_V but 64-bit by default in long mode
+	S_A,		// 16- or 32-bit according to address-size prefix
+	S_P			// far pointer
+} arg_size_t;
 
+// operand accesses
+const t::uint8
+	R = 0x1,
+	W = 0x2,
+	RW = R | W;
+
+typedef struct arg_t {
+	t::uint8 kind;
+	t::uint8 size;
+	t::uint8 access;
+} arg_t;
+
+constexpr arg_t
+	NO		= { A_NONE, S_NONE, 0 },
+
+	Eb_R	= { A_RM, S_8, R },
+	Eb_W	= { A_RM, S_8, W },
+	Eb_RW	= { A_RM, S_8, RW },
+	Ew_R	= { A_RM, S_16, R },
+	Ew_W	= { A_RM, S_16, W },
+	Ew_RW	= { A_RM, S_16, RW },
+	Ed_R	= { A_RM, S_32, R },
+	Ev_N	= { A_RM, S_V, 0 },
+	Ev_R	= { A_RM, S_V, R },
+	Ev_W	= { A_RM, S_V, W },
+	Ev_RW	= { A_RM, S_V, RW },
+	Ev64_R	= { A_RM, S_V64, R },
+	Ev64_W	= { A_RM, S_V64, W },
+
+	Gb_R	= { A_REG, S_8, R },
+	Gb_W	= { A_REG, S_8, W },
+	Gb_RW	= { A_REG, S_8, RW },
+	Gw_R	= { A_REG, S_16, R },
+	Gd_RW	= { A_REG, S_32, RW },
+	Gv_R	= { A_REG, S_V, R },
+	Gv_W	= { A_REG, S_V, W },
+	Gv_RW	= { A_REG, S_V, RW },
+
+	M_N		= { A_MEM, S_NONE, 0 },
+	M_R		= { A_MEM, S_NONE, R },
+	M_W		= { A_MEM, S_NONE, W },
+	Mv_R	= { A_MEM, S_V, R },
+	Mv_W	= { A_MEM, S_V, W },
+	Mp_R	= { A_MEM, S_P, R },
+	Mq_RW	= { A_MEM, S_64, RW },
+
+	Rd_R	= { A_RRM, S_32, R },
+	Rd_W	= { A_RRM, S_32, W },
+	Rv_W	= { A_RRM, S_V, W },
+	Cd_R	= { A_CREG, S_32, R },
+	Cd_W	= { A_CREG, S_32, W },
+	Dd_R	= { A_DREG, S_32, R },
+	Dd_W	= { A_DREG, S_32, W },
+	Sw_R	= { A_SREG, S_16, R },
+	Sw_W	= { A_SREG, S_16, W },
+	So_R	= { A_OSREG, S_16, R },
+	So_W	= { A_OSREG, S_16, W },
+
+	Zb_W	= { A_OREG, S_8, W },
+	Zv_R	= { A_OREG, S_V, R },
+	Zv_W	= { A_OREG, S_V, W },
+	Zv_RW	= { A_OREG, S_V, RW },
+	Zv64_R	= { A_OREG, S_V64, R },
+	Zv64_W	= { A_OREG, S_V64, W },
+
+	AL_R	= { A_ACC, S_8, R },
+	AL_W	= { A_ACC, S_8, W },
+	AL_RW	= { A_ACC, S_8, RW },
+	eAX_R	= { A_ACC, S_V, R },
+	eAX_W	= { A_ACC, S_V, W },
+	eAX_RW	= { A_ACC, S_V, RW },
+	CL_R	= { A_CL, S_8, R },
+	DX_R	= { A_DX, S_16, R },
+	ONE		= { A_ONE, S_8, R },
+
+	Ib		= { A_IMM, S_8, R },
+	UIb		= { A_UIMM, S_8, R },
+	Iw		= { A_UIMM, S_16, R },
+	Iz		= { A_IMM, S_V, R },
+	Jb		= { A_REL, S_8, R },
+	Jz		= { A_REL, S_V, R },
+	Ob_R	= { A_MOFFS, S_8, R },
+	Ob_W	= { A_MOFFS, S_8, W },
+	Ov_R	= { A_MOFFS, S_V, R },
+	Ov_W	= { A_MOFFS, S_V, W },
+	Ap		= { A_PTR, S_P, R },
+
+	Xb_R	= { A_SRC, S_8, R },
+	Xv_R	= { A_SRC, S_V, R },
+	Yb_R	= { A_DST, S_8, R },
+	Yb_W	= { A_DST, S_8, W },
+	Yv_R	= { A_DST, S_V, R },
+	Yv_W	= { A_DST, S_V, W },
+
+	XRM		= { A_XRM, S_NONE, 0 },
+	XIB		= { A_XIB, S_8, 0 };
+
+// instruction kinds
+const Inst::kind_t
+	K_ALU	= Inst::IS_ALU | Inst::IS_INT,
+	K_MUL	= K_ALU | Inst::IS_MUL,
+	K_DIV	= K_ALU | Inst::IS_DIV,
+	K_SHIFT	= K_ALU | Inst::IS_SHIFT,
+	K_JMP	= Inst::IS_CONTROL,
+	K_JCC	= Inst::IS_CONTROL | Inst::IS_COND,
+	K_CALL	= Inst::IS_CONTROL | Inst::IS_CALL,
+	K_RET	= Inst::IS_CONTROL | Inst::IS_RETURN,
+	K_TRAP	= Inst::IS_CONTROL | Inst::IS_TRAP,
+	K_PUSH	= Inst::IS_MEM | Inst::IS_STORE,
+	K_POP	= Inst::IS_MEM | Inst::IS_LOAD,
+	K_LOAD	= Inst::IS_MEM | Inst::IS_LOAD,
+	K_SYS	= Inst::IS_INTERN;
+
+// instruction layout
+const t::uint8
+	L_IMM1		= 0x07,		// size code of the first immediate
+	L_IMM2		= 0x38,		// size code of the second immediate
+	L_MODRM		= 0x40,		// ModR/M byte present
+	L_REGONLY	= 0x80;		// ModR/M only designates registers (no SIB, no displacement)
+
+// immediate size codes
+const t::uint8
+	IMM_NONE	= 0,
+	IMM_1		= 1,
+	IMM_2		= 2,
+	IMM_4		= 3,
+	IMM_V		= 4,		// 2 or 4 bytes according to operand-size prefix
+	IMM_A		= 5;		// 2 or 4 bytes according to address-size prefix
+
+struct sem_tpl_t;
 
 typedef struct inst_t {
-	cstring format;
+	const char *name;
 	Inst::kind_t kind;
-	t::uint32 argc;
-	arg_type_t args[4];
+	t::uint8 argc;
+	t::uint8 layout;
+	arg_t args[3];
+	const sem_tpl_t *sem;		// semantic template (see SEMANTICS)
 } inst_t;
 
+constexpr t::uint8 immCode(const arg_t& a) {
+	return a.kind == A_MOFFS ? IMM_A
+		: (a.kind != A_IMM && a.kind != A_UIMM && a.kind != A_REL && a.kind != A_XIB) ? IMM_NONE
+		: a.size == S_8 ? IMM_1
+		: a.size == S_16 ? IMM_2
+		: a.size == S_32 ? IMM_4
+		: a.size == S_V ? IMM_V
+		: IMM_NONE;
+}
+
+constexpr t::uint8 layoutOf(const arg_t *args) {
+	t::uint8 l = 0;
+	int imms = 0;
+	for(int i = 0; i < 3; i++) {
+		auto k = args[i].kind;
+		if(k == A_REG || k == A_RM || k == A_MEM || k == A_SREG || k == A_XRM)
+			l |= L_MODRM;
+		else if(k == A_RRM || k == A_CREG || k == A_DREG)
+			l |= L_MODRM | L_REGONLY;
+		if(k == A_PTR)
+			l |= IMM_V | (IMM_2 << 3);
+		else {
+			auto c = immCode(args[i]);
+			if(c != IMM_NONE) {
+				l |= imms == 0 ? c : c << 3;
+				imms++;
+			}
+		}
+	}
+	return l;
+}
 
-// Instruction definitions
-static const inst_t
+constexpr inst_t inst(const char *name, Inst::kind_t kind, arg_t a0 = NO, arg_t a1 = NO, arg_t a2 = NO) {
+	inst_t i = { name, kind, 0, 0, { a0, a1, a2 }, nullptr };
+	while(i.argc < 3 && i.args[i.argc].kind != A_NONE)
+		i.argc++;
+	i.layout = layoutOf(i.args);
+	return i;
+}
 
-	// JMP
-	JMP = { "jmp %p", Inst::IS_CONTROL, 1, { IPREL} },
 
-	// mov
-	MOV32 = { "mov %1, %0", Inst::IS_ALU, 2, { R32_W, R32_R }},
-	MOVI_DIS8 = { "movl %0, %1(%2)", Inst::IS_MEM|Inst::IS_STORE, 3, { UIMM, SIMM, R32_R } },
+// generic forms of ALU instructions
+#define X86_ALU(_, N, n, A) \
+	_(N##_EbGb,		n,	K_ALU,	Eb_##A, Gb_R) \
+	_(N##_EvGv,		n,	K_ALU,	Ev_##A, Gv_R) \
+	_(N##_GbEb,		n,	K_ALU,	Gb_##A, Eb_R) \
+	_(N##_GvEv,		n,	K_ALU,	Gv_##A, Ev_R) \
+	_(N##_ALIb,		n,	K_ALU,	AL_##A, Ib) \
+	_(N##_eAXIz,	n,	K_ALU,	eAX_##A, Iz) \
+	_(N##_EbIb,		n,	K_ALU,	Eb_##A, Ib) \
+	_(N##_EvIz,		n,	K_ALU,	Ev_##A, Iz) \
+	_(N##_EvIb,		n,	K_ALU,	Ev_##A, Ib)
 
-	// push/pop
-	PUSH = { "push %0", Inst::IS_MEM|Inst::IS_STORE, 1, { R32_R } },
-	POP = { "pop %0", Inst::IS_MEM|Inst::IS_LOAD, 1, { R32_W } },
+// generic forms of shift instructions
+#define X86_SHIFT(_, N, n) \
+	_(N##_EbIb,		n,	K_SHIFT,	Eb_RW, UIb) \
+	_(N##_EvIb,		n,	K_SHIFT,	Ev_RW, UIb) \
+	_(N##_Eb1,		n,	K_SHIFT,	Eb_RW, ONE) \
+	_(N##_Ev1,		n,	K_SHIFT,	Ev_RW, ONE) \
+	_(N##_EbCL,		n,	K_SHIFT,	Eb_RW, CL_R) \
+	_(N##_EvCL,		n,	K_SHIFT,	Ev_RW, CL_R)
 
-	// sub
-	SUB32I = { "sub %0, %1", Inst::IS_ALU, 2, { SIMM, R32_W }  },
+// conditional forms in condition code order
+#define X86_CC(_, N, n, K, ...) \
+	_(N##O,		n "o",	K,	__VA_ARGS__) \
+	_(N##NO,	n "no",	K,	__VA_ARGS__) \
+	_(N##B,		n "b",	K,	__VA_ARGS__) \
+	_(N##AE,	n "ae",	K,	__VA_ARGS__) \
+	_(N##E,		n "e",	K,	__VA_ARGS__) \
+	_(N##NE,	n "ne",	K,	__VA_ARGS__) \
+	_(N##BE,	n "be",	K,	__VA_ARGS__) \
+	_(N##A,		n "a",	K,	__VA_ARGS__) \
+	_(N##S,		n "s",	K,	__VA_ARGS__) \
+	_(N##NS,	n "ns",	K,	__VA_ARGS__) \
+	_(N##P,		n "p",	K,	__VA_ARGS__) \
+	_(N##NP,	n "np",	K,	__VA_ARGS__) \
+	_(N##L,		n "l",	K,	__VA_ARGS__) \
+	_(N##GE,	n "ge",	K,	__VA_ARGS__) \
+	_(N##LE,	n "le",	K,	__VA_ARGS__) \
+	_(N##G,		n "g",	K,	__VA_ARGS__)
 
-	// special instruction
-	ENDBR32 = { "endbr32", Inst::IS_INTERN, 0 },
+// instruction list: identifier, mnemonic, kind, operands
+#define X86_INSTS(_) \
+	_(UNKNOWN,		"unknown",	0) \
+	_(UNKNOWN_RM,	"unknown",	0,	XRM) \
+	_(X87,			"(x87)",	Inst::IS_FLOAT,	XRM) \
+	_(SSE,			"(sse)",	0,	XRM) \
+	_(SSE_IB,		"(sse)",	0,	XRM, XIB) \
+	_(AVX,			"(avx)",	0) \
+	_(AMD3DNOW,		"(3dnow)",	Inst::IS_FLOAT,	XRM, XIB) \
+	_(SYS_RM,		"(system)",	K_SYS,	XRM) \
+	X86_ALU(_, ADD, "add", RW) \
+	X86_ALU(_, OR, "or", RW) \
+	X86_ALU(_, ADC, "adc", RW) \
+	X86_ALU(_, SBB, "sbb", RW) \
+	X86_ALU(_, AND, "and", RW) \
+	X86_ALU(_, SUB, "sub", RW) \
+	X86_ALU(_, XOR, "xor", RW) \
+	X86_ALU(_, CMP, "cmp", R) \
+	_(PUSH_So,		"push",		K_PUSH,	So_R) \
+	_(POP_So,		"pop",		K_POP,	So_W) \
+	_(DAA,			"daa",		K_ALU) \
+	_(DAS,			"das",		K_ALU) \
+	_(AAA,			"aaa",		K_ALU) \
+	_(AAS,			"aas",		K_ALU) \
+	_(INC_Zv,		"inc",		K_ALU,	Zv_RW) \
+	_(DEC_Zv,		"dec",		K_ALU,	Zv_RW) \
+	_(PUSH_Zv,		"push",		K_PUSH,	Zv64_R) \
+	_(POP_Zv,		"pop",		K_POP,	Zv64_W) \
+	_(PUSHA,		"pusha",	K_PUSH) \
+	_(POPA,			"popa",		K_POP) \
+	_(BOUND,		"bound",	K_TRAP | Inst::IS_COND,	Gv_R, Mv_R) \
+	_(ARPL,			"arpl",		K_SYS,	Ew_RW, Gw_R) \
+	_(PUSH_Iz,		"push",		K_PUSH,	Iz) \
+	_(IMUL_GvEvIz,	"imul",		K_MUL,	Gv_W, Ev_R, Iz) \
+	_(PUSH_Ib,		"push",		K_PUSH,	Ib) \
+	_(IMUL_GvEvIb,	"imul",		K_MUL,	Gv_W, Ev_R, Ib) \
+	_(INSB,			"insb",		K_SYS,	Yb_W, DX_R) \
+	_(INS,			"ins",		K_SYS,	Yv_W, DX_R) \
+	_(OUTSB,		"outsb",	K_SYS,	DX_R, Xb_R) \
+	_(OUTS,			"outs",		K_SYS,	DX_R, Xv_R) \
+	X86_CC(_, J8_, "j", K_JCC, Jb) \
+	_(TEST_EbGb,	"test",		K_ALU,	Eb_R, Gb_R) \
+	_(TEST_EvGv,	"test",		K_ALU,	Ev_R, Gv_R) \
+	_(XCHG_EbGb,	"xchg",		K_ALU,	Eb_RW, Gb_RW) \
+	_(XCHG_EvGv,	"xchg",		K_ALU,	Ev_RW, Gv_RW) \
+	_(MOV_EbGb,		"mov",		K_ALU,	Eb_W, Gb_R) \
+	_(MOV_EvGv,		"mov",		K_ALU,	Ev_W, Gv_R) \
+	_(MOV_GbEb,		"mov",		K_ALU,	Gb_W, Eb_R) \
+	_(MOV_GvEv,		"mov",		K_ALU,	Gv_W, Ev_R) \
+	_(MOV_EwSw,		"mov",		K_ALU,	Ew_W, Sw_R) \
+	_(LEA,			"lea",		K_ALU,	Gv_W, M_N) \
+	_(MOV_SwEw,		"mov",		K_ALU,	Sw_W, Ew_R) \
+	_(POP_Ev,		"pop",		K_POP,	Ev64_W) \
+	_(NOP,			"nop",		K_SYS) \
+	_(PAUSE,		"pause",	K_SYS) \
+	_(XCHG_Zv,		"xchg",		K_ALU,	Zv_RW, eAX_RW) \
+	_(CWDE,			"cwde",		K_ALU) \
+	_(CDQ,			"cdq",		K_ALU) \
+	_(CALLF_Ap,		"call",		K_CALL,	Ap) \
+	_(WAIT,			"wait",		K_SYS) \
+	_(PUSHF,		"pushf",	K_PUSH) \
+	_(POPF,			"popf",		K_POP) \
+	_(SAHF,			"sahf",		K_ALU) \
+	_(LAHF,			"lahf",		K_ALU) \
+	_(MOV_ALOb,		"mov",		K_ALU,	AL_W, Ob_R) \
+	_(MOV_eAXOv,	"mov",		K_ALU,	eAX_W, Ov_R) \
+	_(MOV_ObAL,		"mov",		K_ALU,	Ob_W, AL_R) \
+	_(MOV_OveAX,	"mov",		K_ALU,	Ov_W, eAX_R) \
+	_(MOVSB,		"movsb",	K_ALU,	Yb_W, Xb_R) \
+	_(MOVS,			"movs",		K_ALU,	Yv_W, Xv_R) \
+	_(CMPSB,		"cmpsb",	K_ALU,	Xb_R, Yb_R) \
+	_(CMPS,			"cmps",		K_ALU,	Xv_R, Yv_R) \
+	_(TEST_ALIb,	"test",		K_ALU,	AL_R, Ib) \
+	_(TEST_eAXIz,	"test",		K_ALU,	eAX_R, Iz) \
+	_(STOSB,		"stosb",	K_ALU,	Yb_W, AL_R) \
+	_(STOS,			"stos",		K_ALU,	Yv_W, eAX_R) \
+	_(LODSB,		"lodsb",	K_ALU,	AL_W, Xb_R) \
+	_(LODS,			"lods",		K_ALU,	eAX_W, Xv_R) \
+	_(SCASB,		"scasb",	K_ALU,	AL_R, Yb_R) \
+	_(SCAS,			"scas",		K_ALU,	eAX_R, Yv_R) \
+	_(MOV_ZbIb,		"mov",		K_ALU,	Zb_W, UIb) \
+	_(MOV_ZvIz,		"mov",		K_ALU,	Zv_W, Iz) \
+	X86_SHIFT(_, ROL, "rol") \
+	X86_SHIFT(_, ROR, "ror") \
+	X86_SHIFT(_, RCL, "rcl") \
+	X86_SHIFT(_, RCR, "rcr") \
+	X86_SHIFT(_, SHL, "shl") \
+	X86_SHIFT(_, SHR, "shr") \
+	X86_SHIFT(_, SAR, "sar") \
+	_(RET_Iw,		"ret",		K_RET,	Iw) \
+	_(RET,			"ret",		K_RET) \
+	_(LES,			"les",		K_ALU,	Gv_W, Mp_R) \
+	_(LDS,			"lds",		K_ALU,	Gv_W, Mp_R) \
+	_(MOV_EbIb,		"mov",		K_ALU,	Eb_W, UIb) \
+	_(MOV_EvIz,		"mov",		K_ALU,	Ev_W, Iz) \
+	_(ENTER,		"enter",	K_PUSH,	Iw, UIb) \
+	_(LEAVE,		"leave",	K_POP) \
+	_(RETF_Iw,		"retf",		K_RET,	Iw) \
+	_(RETF,			"retf",		K_RET) \
+	_(INT3,			"int3",		K_TRAP) \
+	_(INT,			"int",		K_TRAP,	UIb) \
+	_(INTO,			"into",		K_TRAP | Inst::IS_COND) \
+	_(IRET,			"iret",		K_RET) \
+	_(AAM,			"aam",		K_ALU,	UIb) \
+	_(AAD,			"aad",		K_ALU,	UIb) \
+	_(SALC,			"salc",		K_ALU) \
+	_(XLAT,			"xlat",		K_LOAD) \
+	_(LOOPNE,		"loopne",	K_JCC,	Jb) \
+	_(LOOPE,		"loope",	K_JCC,	Jb) \
+	_(LOOP,			"loop",		K_JCC,	Jb) \
+	_(JECXZ,		"jecxz",	K_JCC,	Jb) \
+	_(IN_ALIb,		"in",		K_SYS,	AL_W, UIb) \
+	_(IN_eAXIb,		"in",		K_SYS,	eAX_W, UIb) \
+	_(OUT_IbAL,		"out",		K_SYS,	UIb, AL_R) \
+	_(OUT_IbeAX,	"out",		K_SYS,	UIb, eAX_R) \
+	_(CALL_Jz,		"call",		K_CALL,	Jz) \
+	_(JMP_Jz,		"jmp",		K_JMP,	Jz) \
+	_(JMPF_Ap,		"jmp",		K_JMP,	Ap) \
+	_(JMP_Jb,		"jmp",		K_JMP,	Jb) \
+	_(IN_ALDX,		"in",		K_SYS,	AL_W, DX_R) \
+	_(IN_eAXDX,		"in",		K_SYS,	eAX_W, DX_R) \
+	_(OUT_DXAL,		"out",		K_SYS,	DX_R, AL_R) \
+	_(OUT_DXeAX,	"out",		K_SYS,	DX_R, eAX_R) \
+	_(INT1,			"int1",		K_TRAP) \
+	_(HLT,			"hlt",		K_SYS) \
+	_(CMC,			"cmc",		K_ALU) \
+	_(TEST_EbIb,	"test",		K_ALU,	Eb_R, Ib) \
+	_(TEST_EvIz,	"test",		K_ALU,	Ev_R, Iz) \
+	_(NOT_Eb,		"not",		K_ALU,	Eb_RW) \
+	_(NOT_Ev,		"not",		K_ALU,	Ev_RW) \
+	_(NEG_Eb,		"neg",		K_ALU,	Eb_RW) \
+	_(NEG_Ev,		"neg",		K_ALU,	Ev_RW) \
+	_(MUL_Eb,		"mul",		K_MUL,	Eb_R) \
+	_(MUL_Ev,		"mul",		K_MUL,	Ev_R) \
+	_(IMUL_Eb,		"imul",		K_MUL,	Eb_R) \
+	_(IMUL_Ev,		"imul",		K_MUL,	Ev_R) \
+	_(DIV_Eb,		"div",		K_DIV,	Eb_R) \
+	_(DIV_Ev,		"div",		K_DIV,	Ev_R) \
+	_(IDIV_Eb,		"idiv",		K_DIV,	Eb_R) \
+	_(IDIV_Ev,		"idiv",		K_DIV,	Ev_R) \
+	_(CLC,			"clc",		K_ALU) \
+	_(STC,			"stc",		K_ALU) \
+	_(CLI,			"cli",		K_SYS) \
+	_(STI,			"sti",		K_SYS) \
+	_(CLD,			"cld",		K_ALU) \
+	_(STD,			"std",		K_ALU) \
+	_(INC_Eb,		"inc",		K_ALU,	Eb_RW) \
+	_(DEC_Eb,		"dec",		K_ALU,	Eb_RW) \
+	_(INC_Ev,		"inc",		K_ALU,	Ev_RW) \
+	_(DEC_Ev,		"dec",		K_ALU,	Ev_RW) \
+	_(CALL_Ev,		"call",		K_CALL | Inst::IS_INDIRECT,	Ev64_R) \
+	_(CALLF_Mp,		"call",		K_CALL | Inst::IS_INDIRECT,	Mp_R) \
+	_(JMP_Ev,		"jmp",		K_JMP | Inst::IS_INDIRECT,	Ev64_R) \
+	_(JMPF_Mp,		"jmp",		K_JMP | Inst::IS_INDIRECT,	Mp_R) \
+	_(PUSH_Ev,		"push",		K_PUSH,	Ev64_R) \
+	_(SLDT,			"sldt",		K_SYS,	Ew_W) \
+	_(STR,			"str",		K_SYS,	Ew_W) \
+	_(LLDT,			"lldt",		K_SYS,	Ew_R) \
+	_(LTR,			"ltr",		K_SYS,	Ew_R) \
+	_(VERR,			"verr",		K_SYS,	Ew_R) \
+	_(VERW,			"verw",		K_SYS,	Ew_R) \
+	_(SGDT,			"sgdt",		K_SYS,	M_W) \
+	_(SIDT,			"sidt",		K_SYS,	M_W) \
+	_(LGDT,			"lgdt",		K_SYS,	M_R) \
+	_(LIDT,			"lidt",		K_SYS,	M_R) \
+	_(SMSW,			"smsw",		K_SYS,	Ew_W) \
+	_(LMSW,			"lmsw",		K_SYS,	Ew_R) \
+	_(INVLPG,		"invlpg",	K_SYS,	M_N) \
+	_(LAR,			"lar",		K_SYS,	Gv_W, Ew_R) \
+	_(LSL,			"lsl",		K_SYS,	Gv_W, Ew_R) \
+	_(SYSCALL,		"syscall",	K_TRAP) \
+	_(CLTS,			"clts",		K_SYS) \
+	_(SYSRET,		"sysret",	K_RET) \
+	_(INVD,			"invd",		K_SYS) \
+	_(WBINVD,		"wbinvd",	K_SYS) \
+	_(UD2,			"ud2",		K_TRAP) \
+	_(PREFETCH,		"prefetch",	K_SYS,	XRM) \
+	_(FEMMS,		"femms",	Inst::IS_FLOAT) \
+	_(NOP_Ev,		"nop",		K_SYS,	Ev_N) \
+	_(ENDBR32,		"endbr32",	K_SYS,	XRM) \
+	_(ENDBR64,		"endbr64",	K_SYS,	XRM) \
+	_(MOV_RdCd,		"mov",		K_SYS,	Rd_W, Cd_R) \
+	_(MOV_RdDd,		"mov",		K_SYS,	Rd_W, Dd_R) \
+	_(MOV_CdRd,		"mov",		K_SYS,	Cd_W, Rd_R) \
+	_(MOV_DdRd,		"mov",		K_SYS,	Dd_W, Rd_R) \
+	_(WRMSR,		"wrmsr",	K_SYS) \
+	_(RDTSC,		"rdtsc",	K_SYS) \
+	_(RDMSR,		"rdmsr",	K_SYS) \
+	_(RDPMC,		"rdpmc",	K_SYS) \
+	_(SYSENTER,		"sysenter",	K_TRAP) \
+	_(SYSEXIT,		"sysexit",	K_RET) \
+	_(GETSEC,		"getsec",	K_SYS) \
+	X86_CC(_, CMOV_, "cmov", K_ALU | Inst::IS_COND, Gv_RW, Ev_R) \
+	_(EMMS,			"emms",		Inst::IS_FLOAT) \
+	X86_CC(_, J32_, "j", K_JCC, Jz) \
+	X86_CC(_, SET_, "set", K_ALU, Eb_W) \
+	_(CPUID,		"cpuid",	K_SYS) \
+	_(BT_EvGv,		"bt",		K_ALU,	Ev_R, Gv_R) \
+	_(SHLD_EvGvIb,	"shld",		K_SHIFT,	Ev_RW, Gv_R, UIb) \
+	_(SHLD_EvGvCL,	"shld",		K_SHIFT,	Ev_RW, Gv_R, CL_R) \
+	_(RSM,			"rsm",		K_RET) \
+	_(BTS_EvGv,		"bts",		K_ALU,	Ev_RW, Gv_R) \
+	_(SHRD_EvGvIb,	"shrd",		K_SHIFT,	Ev_RW, Gv_R, UIb) \
+	_(SHRD_EvGvCL,	"shrd",		K_SHIFT,	Ev_RW, Gv_R, CL_R) \
+	_(LFENCE,		"lfence",	K_SYS,	XRM) \
+	_(MFENCE,		"mfence",	K_SYS,	XRM) \
+	_(SFENCE,		"sfence",	K_SYS,	XRM) \
+	_(IMUL_GvEv,	"imul",		K_MUL,	Gv_RW, Ev_R) \
+	_(CMPXCHG_EbGb,	"cmpxchg",	K_ALU,	Eb_RW, Gb_R) \
+	_(CMPXCHG_EvGv,	"cmpxchg",	K_ALU,	Ev_RW, Gv_R) \
+	_(LSS,			"lss",		K_ALU,	Gv_W, Mp_R) \
+	_(BTR_EvGv,		"btr",		K_ALU,	Ev_RW, Gv_R) \
+	_(LFS,			"lfs",		K_ALU,	Gv_W, Mp_R) \
+	_(LGS,			"lgs",		K_ALU,	Gv_W, Mp_R) \
+	_(MOVZX_GvEb,	"movzx",	K_ALU,	Gv_W, Eb_R) \
+	_(MOVZX_GvEw,	"movzx",	K_ALU,	Gv_W, Ew_R) \
+	_(POPCNT,		"popcnt",	K_ALU,	Gv_W, Ev_R) \
+	_(UD1,			"ud1",		K_TRAP,	XRM) \
+	_(BT_EvIb,		"bt",		K_ALU,	Ev_R, UIb) \
+	_(BTS_EvIb,		"bts",		K_ALU,	Ev_RW, UIb) \
+	_(BTR_EvIb,		"btr",		K_ALU,	Ev_RW, UIb) \
+	_(BTC_EvIb,		"btc",		K_ALU,	Ev_RW, UIb) \
+	_(BTC_EvGv,		"btc",		K_ALU,	Ev_RW, Gv_R) \
+	_(BSF,			"bsf",		K_ALU,	Gv_RW, Ev_R) \
+	_(TZCNT,		"tzcnt",	K_ALU,	Gv_W, Ev_R) \
+	_(BSR,			"bsr",		K_ALU,	Gv_RW, Ev_R) \
+	_(LZCNT,		"lzcnt",	K_ALU,	Gv_W, Ev_R) \
+	_(MOVSX_GvEb,	"movsx",	K_ALU,	Gv_W, Eb_R) \
+	_(MOVSX_GvEw,	"movsx",	K_ALU,	Gv_W, Ew_R) \
+	_(XADD_EbGb,	"xadd",		K_ALU,	Eb_RW, Gb_RW) \
+	_(XADD_EvGv,	"xadd",		K_ALU,	Ev_RW, Gv_RW) \
+	_(MOVNTI,		"movnti",	K_ALU,	Mv_W, Gv_R) \
+	_(CMPXCHG8B,	"cmpxchg8b",	K_ALU,	Mq_RW) \
+	_(RDRAND,		"rdrand",	K_SYS,	Rv_W) \
+	_(RDSEED,		"rdseed",	K_SYS,	Rv_W) \
+	_(BSWAP,		"bswap",	K_ALU,	Zv_RW) \
+	_(UD0,			"ud0",		K_TRAP,	XRM) \
+	_(MOVBE_GvMv,	"movbe",	K_ALU,	Gv_W, Mv_R) \
+	_(MOVBE_MvGv,	"movbe",	K_ALU,	Mv_W, Gv_R) \
+	_(CRC32_GdEb,	"crc32",	K_ALU,	Gd_RW, Eb_R) \
+	_(CRC32_GdEv,	"crc32",	K_ALU,	Gd_RW, Ev_R) \
+	_(ADCX,			"adcx",		K_ALU,	Gd_RW, Ed_R) \
+	_(ADOX,			"adox",		K_ALU,	Gd_RW, Ed_R) \
+	_(MOVSXD,		"movsxd",	K_ALU,	Gv_W, Ed_R)
 
-	UNKNOWN = {"unknown", 0, 0 };
+#define X86_ID(id, ...)		I_##id,
+#define X86_DESC(id, ...)	withSem(inst(__VA_ARGS__), &SEMS[I_##id]),
 
+typedef enum {
+	X86_INSTS(X86_ID)
+	I_COUNT
+} inst_id_t;
 
-// Decoder class
-class Decoder: public otawa::Decoder {
-public:
+constexpr bool in(int i, int f, int l) { return f <= i && i <= l; }
 
-	typedef enum {
-		MODE_NONE = 0,
-		MODE_REAL = 1,
-		MODE_PROTECT = 2,
-		MODE_LONG = 3
-	} mode_t;
 
-	t::int32
-		PREF_LOCK		= 0x0001,
-		PREF_REPNEZ		= 0x0002,
-		PREF_REPEZZ		= 0x0004,
-		PREF_NOT_TAKEN	= 0x0008,
-		PREF_TAKEN		= 0x0010,
-		PREF_OPER_OVER	= 0x0020,
-		PREF_ADDR_OVER	= 0x0040;
+/**
+ * SEMANTICS
+ *
+ * The semantic instructions of an instruction form are described by a
+ * template computed at compile time and attached to its descriptor. The
+ * operands of a template are either fixed platform registers (32-bit
+ * registers standing for their 64-bit counterpart in long mode) or
+ * placeholders: the value of an argument (Vi), the address of a memory
+ * argument (Ai) or a temporary (Ti).
+ *
+ * Instantiating a template only patches the placeholders: an argument
+ * value is its register, or a temporary set to the immediate or loaded
+ * from memory before the template and stored back after it if written.
+ * Forms without template are translated as a scratch of the written
+ * registers.
+ */
 
-	Decoder(gel::Image *image): otawa::Decoder(image) {}
+// template operands
+const t::int8
+	V0 = -1, V1 = -2, V2 = -3,		// value of argument i
+	A0 = -4, A1 = -5, A2 = -6,		// address of memory argument i
+	T1 = -7, T2 = -8, T3 = -9,		// temporaries
+	RF = R_EFLAGS;
 
-	otawa::Inst * decode(gel::address_t a) override {
+// constants of SETI (a field)
+const t::int8
+	K_CST	= 0,		// constant of the template
+	K_WORD	= 1,		// size of the stack word in bytes
+	K_NEXT	= 2;		// address of the next instruction
 
-		// look for the segment
-		if(curs.size() == 0 || base > a || a >= base + curs.size()) {
-			bool found = false;
-			for(auto s: image()->segments())
-				if(s->range().contains(a)) {
-					if(!s->isExecutable())
-						return nullptr;
-					curs = s->buffer();
-					base = s->baseAddress();
-					found = true;
-					break;
-			}
-			if(!found)
-				return nullptr;
+// type of LOAD/STORE (b field) of the stack word
+const t::int8 TY_WORD = -16;
+
+typedef struct sem_t {
+	t::uint8 op;
+	t::int8 d, a, b;
+	t::int32 cst;
+} sem_t;
+
+const int MAX_SEM = 6;
+
+typedef struct sem_tpl_t {
+	t::uint8 count;
+	bool known;
+	t::uint8 uses;		// bit i: Vi used, bit i + 3: Ai used
+	sem_t insts[MAX_SEM];
+} sem_tpl_t;
+
+constexpr sem_t NO_SEM = { sem::NOP, 0, 0, 0, 0 };
+
+constexpr sem_t s(sem::opcode op, int d = 0, int a = 0, int b = 0) {
+	return { t::uint8(op), t::int8(d), t::int8(a), t::int8(b), 0 };
+}
+
+constexpr sem_t seti(int d, t::int8 k, t::int32 c = 0) {
+	return { sem::SETI, t::int8(d), k, 0, c };
+}
+
+constexpr sem_tpl_t tpl(sem_t i0 = NO_SEM, sem_t i1 = NO_SEM, sem_t i2 = NO_SEM,
+sem_t i3 = NO_SEM, sem_t i4 = NO_SEM, sem_t i5 = NO_SEM) {
+	sem_tpl_t t = { 0, true, 0, { i0, i1, i2, i3, i4, i5 } };
+	while(t.count < MAX_SEM && t.insts[t.count].op != sem::NOP) {
+		const sem_t& i = t.insts[t.count++];
+		for(int c: { i.d, i.a, i.b })
+			if(A2 <= c && c < 0)
+				t.uses |= 1 << (V0 - c);
+	}
+	return t;
+}
+
+// conditions in condition code order (O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G)
+static constexpr t::int8 CONDS[] = {
+	sem::ANY_COND, sem::ANY_COND, sem::ULT, sem::UGE, sem::EQ, sem::NE, sem::ULE, sem::UGT,
+	sem::ANY_COND, sem::ANY_COND, sem::ANY_COND, sem::ANY_COND, sem::LT, sem::GE, sem::LE, sem::GT
+};
+
+// ALU forms of a family (in X86_ALU order)
+constexpr bool alu(int i, int f) { return in(i, f, f + I_ADD_EvIb - I_ADD_EbGb); }
+
+// shift forms of a family (in X86_SHIFT order)
+constexpr bool shift(int i, int f) { return in(i, f, f + I_ROL_EvCL - I_ROL_EbIb); }
+
+constexpr sem_tpl_t semOf(int i) {
+	const sem_tpl_t
+		push = tpl(s(sem::SET, T2, V0), seti(T1, K_WORD), s(sem::SUB, R_ESP, R_ESP, T1), s(sem::STORE, T2, R_ESP, TY_WORD)),
+		pop = tpl(s(sem::LOAD, V0, R_ESP, TY_WORD), seti(T1, K_WORD), s(sem::ADD, R_ESP, R_ESP, T1)),
+		call = tpl(seti(T1, K_WORD), s(sem::SUB, R_ESP, R_ESP, T1), seti(T2, K_NEXT), s(sem::STORE, T2, R_ESP, TY_WORD), s(sem::BRANCH, V0)),
+		logic = tpl(seti(T1, K_CST, 0), s(sem::CMP, RF, V0, T1)),
+		scratch = tpl(s(sem::SCRATCH, V0), s(sem::SCRATCH, RF));
+
+	if(alu(i, I_ADD_EbGb))
+		return tpl(s(sem::ADD, V0, V0, V1), s(sem::SCRATCH, RF));
+	else if(alu(i, I_OR_EbGb))
+		return tpl(s(sem::OR, V0, V0, V1), logic.insts[0], logic.insts[1]);
+	else if(alu(i, I_AND_EbGb))
+		return tpl(s(sem::AND, V0, V0, V1), logic.insts[0], logic.insts[1]);
+	else if(alu(i, I_XOR_EbGb))
+		return tpl(s(sem::XOR, V0, V0, V1), logic.insts[0], logic.insts[1]);
+	else if(alu(i, I_SUB_EbGb))
+		return tpl(s(sem::CMP, RF, V0, V1), s(sem::SUB, V0, V0, V1));
+	else if(alu(i, I_CMP_EbGb))
+		return tpl(s(sem::CMP, RF, V0, V1));
+	else if(alu(i, I_ADC_EbGb) || alu(i, I_SBB_EbGb)
+	|| shift(i, I_ROL_EbIb) || shift(i, I_ROR_EbIb) || shift(i, I_RCL_EbIb) || shift(i, I_RCR_EbIb))
+		return scratch;
+	else if(shift(i, I_SHL_EbIb))
+		return tpl(s(sem::SHL, V0, V0, V1), s(sem::SCRATCH, RF));
+	else if(shift(i, I_SHR_EbIb))
+		return tpl(s(sem::SHR, V0, V0, V1), s(sem::SCRATCH, RF));
+	else if(shift(i, I_SAR_EbIb))
+		return tpl(s(sem::ASR, V0, V0, V1), s(sem::SCRATCH, RF));
+	else if(in(i, I_J8_O, I_J8_G))
+		return tpl(s(sem::IF, RF, CONDS[i - I_J8_O], 1), s(sem::BRANCH, V0));
+	else if(in(i, I_J32_O, I_J32_G))
+		return tpl(s(sem::IF, RF, CONDS[i - I_J32_O], 1), s(sem::BRANCH, V0));
+	else if(in(i, I_CMOV_O, I_CMOV_G))
+		return tpl(s(sem::IF, RF, CONDS[i - I_CMOV_O], 1), s(sem::SET, V0, V1));
+	else if(in(i, I_SET_O, I_SET_G))
+		return tpl(s(sem::SCRATCH, V0));
+
+	switch(i) {
+	case I_TEST_EbGb: case I_TEST_EvGv: case I_TEST_ALIb: case I_TEST_eAXIz:
+	case I_TEST_EbIb: case I_TEST_EvIz:
+		return tpl(s(sem::AND, T1, V0, V1), seti(T2, K_CST, 0), s(sem::CMP, RF, T1, T2));
+	case I_INC_Zv: case I_INC_Eb: case I_INC_Ev:
+		return tpl(seti(T1, K_CST, 1), s(sem::ADD, V0, V0, T1), s(sem::SCRATCH, RF));
+	case I_DEC_Zv: case I_DEC_Eb: case I_DEC_Ev:
+		return tpl(seti(T1, K_CST, 1), s(sem::CMP, RF, V0, T1), s(sem::SUB, V0, V0, T1));
+	case I_NOT_Eb: case I_NOT_Ev:
+		return tpl(s(sem::NOT, V0, V0));
+	case I_NEG_Eb: case I_NEG_Ev:
+		return tpl(s(sem::NEG, V0, V0), s(sem::SCRATCH, RF));
+	case I_IMUL_GvEvIz: case I_IMUL_GvEvIb:
+		return tpl(s(sem::MUL, V0, V1, V2), s(sem::SCRATCH, RF));
+	case I_IMUL_GvEv:
+		return tpl(s(sem::MUL, V0, V0, V1), s(sem::SCRATCH, RF));
+	case I_MOV_EbGb: case I_MOV_EvGv: case I_MOV_GbEb: case I_MOV_GvEv:
+	case I_MOV_EwSw: case I_MOV_SwEw: case I_MOV_ALOb: case I_MOV_eAXOv:
+	case I_MOV_ObAL: case I_MOV_OveAX: case I_MOV_ZbIb: case I_MOV_ZvIz:
+	case I_MOV_EbIb: case I_MOV_EvIz: case I_MOVNTI:
+	case I_MOVZX_GvEb: case I_MOVZX_GvEw: case I_MOVSX_GvEb: case I_MOVSX_GvEw: case I_MOVSXD:
+		return tpl(s(sem::SET, V0, V1));
+	case I_LEA:
+		return tpl(s(sem::SET, V0, A1));
+	case I_XCHG_EbGb: case I_XCHG_EvGv: case I_XCHG_Zv:
+		return tpl(s(sem::SET, T1, V0), s(sem::SET, V0, V1), s(sem::SET, V1, T1));
+	case I_PUSH_Zv: case I_PUSH_Iz: case I_PUSH_Ib: case I_PUSH_Ev:
+		return push;
+	case I_POP_Zv: case I_POP_Ev:
+		return pop;
+	case I_LEAVE:
+		return tpl(s(sem::SET, R_ESP, R_EBP), s(sem::LOAD, R_EBP, R_ESP, TY_WORD),
+			seti(T1, K_WORD), s(sem::ADD, R_ESP, R_ESP, T1));
+	case I_CALL_Jz: case I_CALL_Ev:
+		return call;
+	case I_JMP_Jz: case I_JMP_Jb: case I_JMP_Ev:
+		return tpl(s(sem::BRANCH, V0));
+	case I_RET:
+		return tpl(s(sem::LOAD, T1, R_ESP, TY_WORD), seti(T2, K_WORD), s(sem::ADD, R_ESP, R_ESP, T2),
+			s(sem::BRANCH, T1));
+	case I_RET_Iw:
+		return tpl(s(sem::LOAD, T1, R_ESP, TY_WORD), seti(T2, K_WORD), s(sem::ADD, R_ESP, R_ESP, T2),
+			s(sem::ADD, R_ESP, R_ESP, V0), s(sem::BRANCH, T1));
+	case I_LOOP:
+		return tpl(seti(T1, K_CST, 1), s(sem::SUB, R_ECX, R_ECX, T1), seti(T2, K_CST, 0),
+			s(sem::CMP, T3, R_ECX, T2), s(sem::IF, T3, sem::NE, 1), s(sem::BRANCH, V0));
+	case I_LOOPE: case I_LOOPNE:
+		return tpl(seti(T1, K_CST, 1), s(sem::SUB, R_ECX, R_ECX, T1),
+			s(sem::IF, RF, sem::ANY_COND, 1), s(sem::BRANCH, V0));
+	case I_JECXZ:
+		return tpl(seti(T1, K_CST, 0), s(sem::CMP, T2, R_ECX, T1), s(sem::IF, T2, sem::EQ, 1),
+			s(sem::BRANCH, V0));
+	case I_INT3: case I_INT1: case I_UD0: case I_UD1: case I_UD2:
+		return tpl(s(sem::TRAP));
+	case I_NOP: case I_PAUSE: case I_NOP_Ev: case I_ENDBR32: case I_ENDBR64: case I_WAIT:
+	case I_PREFETCH: case I_LFENCE: case I_MFENCE: case I_SFENCE:
+		return tpl();
+	default: {
+			sem_tpl_t t = tpl();
+			t.known = false;
+			return t;
 		}
-		curs.move(a - base);
-
-		// scan prefixes
-		hard::Register *seg = nullptr;
-		t::uint8 byte;
-		t::uint32 prefs = 0;
-		bool done = false;
-		while(!done) {
-			if(!curs.read(byte))
-				return unknown(a, size(a));
-			curs.read(byte);
-			switch(byte) {
-			case 0xF0: prefs |= PREF_LOCK; break;
-			case 0xF2: prefs |= PREF_REPNEZ; break;
-			case 0xF3: prefs |= PREF_REPEZZ; break;
-			case 0x2E: seg = &CS; prefs |= PREF_NOT_TAKEN; break;
-			case 0x36: seg = &SS; break;
-			case 0x3E: seg = &DS; prefs |= PREF_TAKEN; break;
-			case 0x26: seg = &ES; break;
-			case 0x64: seg = &FS; break;
-			case 0x65: seg = &GS; break;
-			case 0x66: prefs |= PREF_OPER_OVER; break;
-			case 0x67: prefs |= PREF_ADDR_OVER; break;
-			default: done = true; break;
-			}
+	}
+}
+
+#define X86_SEM(id, ...)	semOf(I_##id),
+
+static constexpr sem_tpl_t SEMS[] = {
+	X86_INSTS(X86_SEM)
+};
+
+constexpr inst_t withSem(inst_t i, const sem_tpl_t *sem) {
+	i.sem = sem;
+	return i;
+}
+
+static constexpr inst_t INSTS[] = {
+	X86_INSTS(X86_DESC)
+};
+
+
+/**
+ * REGISTER MASKS
+ *
+ * The registers read and written by an instruction are computed at decode
+ * time as bit masks where bit n stands for the register number n (see
+ * reg_num_t). The masks are closed under aliasing: an access to a register
+ * is an access to all registers sharing bits with it (AL, AH, AX, EAX) and
+ * a partial write (AL, AX) also reads the enclosing registers whose other
+ * bits are kept.
+ *
+ * The implicit operands (stack pointer, flags, fixed registers of MUL,
+ * DIV, CPUID, etc) are computed at compile time for each descriptor.
+ */
+typedef RegMask::mask_t regmask_t;
+
+constexpr regmask_t bit(int r) { return regmask_t(1) << r; }
+
+typedef struct alias_t {
+	regmask_t alias[R_COUNT];		// registers sharing bits
+	regmask_t enclosing[R_COUNT];	// registers containing the register
+} alias_t;
+
+// in long mode, the 64-bit registers enclose the 32-bit ones but a 32-bit
+// write clears the upper bits of the 64-bit register: it is a full write
+constexpr alias_t makeAliases(bool long_mode) {
+	alias_t t = { { 0 }, { 0 } };
+	for(int r = 0; r < R_COUNT; r++)
+		t.alias[r] = bit(r);
+	const int groups[][5] = {
+		{ R_EAX, R_AX, R_AL, R_AH, R_RAX },
+		{ R_EBX, R_BX, R_BL, R_BH, R_RBX },
+		{ R_ECX, R_CX, R_CL, R_CH, R_RCX },
+		{ R_EDX, R_DX, R_DL, R_DH, R_RDX },
+		{ R_ESP, R_SP, -1, -1, R_RSP },
+		{ R_EBP, R_BP, -1, -1, R_RBP },
+		{ R_ESI, R_SI, -1, -1, R_RSI },
+		{ R_EDI, R_DI, -1, -1, R_RDI },
+		{ R_EIP, R_IP, -1, -1, R_RIP }
+	};
+	for(int i = 0; i < 9; i++) {
+		int e = groups[i][0], x = groups[i][1], l = groups[i][2], h = groups[i][3];
+		regmask_t all = bit(e) | bit(x), ext = 0;
+		if(long_mode) {
+			ext = bit(groups[i][4]);
+			all |= ext;
+		}
+		t.enclosing[x] = bit(e) | ext;
+		if(l >= 0) {
+			all |= bit(l) | bit(h);
+			t.alias[l] = bit(l) | bit(x) | bit(e) | ext;
+			t.alias[h] = bit(h) | bit(x) | bit(e) | ext;
+			t.enclosing[l] = t.enclosing[h] = bit(x) | bit(e) | ext;
 		}
+		t.alias[e] = t.alias[x] = all;
+		if(long_mode)
+			t.alias[groups[i][4]] = all;
+	}
+	return t;
+}
 
-		// scan opcode
-		t::uint8 opcode;
-		curs.read(opcode);
-		switch(opcode) {
+static constexpr alias_t
+	ALIASES = makeAliases(false),
+	ALIASES64 = makeAliases(true);
 
-		// one-byte instructions
-		case 0X50: case 0x51: case 0x52: case 0x53:
-		case 0X54: case 0x55: case 0x56: case 0x57:
-				return make(a, PUSH, opcode & 0x7);
+template <mode_t M>
+constexpr const alias_t& aliases() { return M == MODE_LONG ? ALIASES64 : ALIASES; }
 
-		case 0X58: case 0x59: case 0x5A: case 0x5B:
-		case 0X5C: case 0x5D: case 0x5E: case 0x5F:
-				return make(a, POP, opcode & 0x7);
+typedef struct implicit_t {
+	regmask_t read, write;
+} implicit_t;
 
-		case 0xEB: {
-				t::int8 dis;
-				if(!curs.read(dis))
-					return unknown(a, size(a));
-				return make(a, JMP, t::int32(dis));
-			}
-			break;
+// ALU instructions not changing the flags
+constexpr bool keepsFlags(int i) {
+	switch(i) {
+	case I_MOV_EbGb: case I_MOV_EvGv: case I_MOV_GbEb: case I_MOV_GvEv:
+	case I_MOV_EwSw: case I_MOV_SwEw: case I_MOV_ALOb: case I_MOV_eAXOv:
+	case I_MOV_ObAL: case I_MOV_OveAX: case I_MOV_ZbIb: case I_MOV_ZvIz:
+	case I_MOV_EbIb: case I_MOV_EvIz: case I_LEA:
+	case I_XCHG_EbGb: case I_XCHG_EvGv: case I_XCHG_Zv:
+	case I_CWDE: case I_CDQ: case I_LAHF: case I_SALC:
+	case I_MOVSB: case I_MOVS: case I_STOSB: case I_STOS: case I_LODSB: case I_LODS:
+	case I_LES: case I_LDS: case I_LSS: case I_LFS: case I_LGS:
+	case I_NOT_Eb: case I_NOT_Ev: case I_BSWAP:
+	case I_MOVZX_GvEb: case I_MOVZX_GvEw: case I_MOVSX_GvEb: case I_MOVSX_GvEw:
+	case I_MOVNTI: case I_MOVBE_GvMv: case I_MOVBE_MvGv:
+	case I_CRC32_GdEb: case I_CRC32_GdEv: case I_MOVSXD:
+		return true;
+	default:
+		return in(i, I_CMOV_O, I_CMOV_G) || in(i, I_SET_O, I_SET_G);
+	}
+}
 
-		// 2-bytes or more
-		case 0x0F: {
-				if(!curs.read(opcode))
-					return unknown(a, size(a));
-				switch(opcode) {
-
-				case 0x1e: {
-						if(!curs.avail(1))
-							return unknown(a, size(a));
-						curs.read(opcode);
-						switch(opcode) {
-						case 0xfb:	return make(a, ENDBR32);
-						default:	return unknown(a, size(a));
-						}
-					}
+// implicit operands of an instruction
+constexpr implicit_t implicitOf(int i) {
+	implicit_t m = { 0, 0 };
+	const Inst::kind_t k = INSTS[i].kind;
+	const regmask_t
+		EFL = bit(R_EFLAGS), SP = bit(R_ESP), BP = bit(R_EBP),
+		A = bit(R_EAX), B = bit(R_EBX), C = bit(R_ECX), D = bit(R_EDX),
+		GPR = A | B | C | D | SP | BP | bit(R_ESI) | bit(R_EDI);
 
-				case 0x38:	// 3-bytes opcode 1
-				case 0x3a:	// 3-bytes opcode 2
-					return unknown(a, size(a));
-				}
-			}
-			break;
+	// flags
+	if((k & Inst::IS_ALU) && !keepsFlags(i))
+		m.write |= EFL;
+	if(in(i, I_ADC_EbGb, I_ADC_EvIb) || in(i, I_SBB_EbGb, I_SBB_EvIb)
+	|| in(i, I_RCL_EbIb, I_RCL_EvCL) || in(i, I_RCR_EbIb, I_RCR_EvCL)
+	|| in(i, I_J8_O, I_J8_G) || in(i, I_J32_O, I_J32_G)
+	|| in(i, I_CMOV_O, I_CMOV_G) || in(i, I_SET_O, I_SET_G)
+	|| in(i, I_INSB, I_OUTS) || in(i, I_MOVSB, I_CMPS) || in(i, I_STOSB, I_SCAS))
+		m.read |= EFL;
 
-		// instruction with ModR/M
-		default: {
-				t::uint8 modrm;
-				if(!curs.read(modrm))
-					return unknown(a, size(a));
-				auto mod = modrm_mod(modrm), reg = modrm_reg(modrm), rm = modrm_rm(modrm);
-				switch(opcode) {
-				case 0x89:
-					switch(mod) {
-					case 0b11:
-						return make(a, MOV32, rm, reg);
-					}
-					break;
+	// stack
+	if(k == K_PUSH || (k == K_POP && i != I_XLAT) || (k & (Inst::IS_CALL | Inst::IS_RETURN)))
+		m.read |= SP, m.write |= SP;
 
-				case 0x83: {
-						switch(mod) {
-						case 0b11: {
-								t::int8 imm;
-								if(!curs.read(imm))
-									return unknown(a, size(a));
-								return make(a, alu_imm(reg), t::int32(imm), rm);
-							}
-							break;
-						}
-					}
-					break;
+	// specific operands
+	switch(i) {
+	case I_PUSHA:		m.read |= GPR; break;
+	case I_POPA:		m.write |= GPR; break;
+	case I_PUSHF:		m.read |= EFL; break;
+	case I_POPF:		m.write |= EFL; break;
+	case I_DAA:
+	case I_DAS:			m.read |= bit(R_AL) | EFL; m.write |= bit(R_AL); break;
+	case I_AAA:
+	case I_AAS:			m.read |= bit(R_AX) | EFL; m.write |= bit(R_AX); break;
+	case I_AAM:
+	case I_AAD:			m.read |= bit(R_AX); m.write |= bit(R_AX); break;
+	case I_CWDE:		m.read |= bit(R_AX); m.write |= A; break;
+	case I_CDQ:			m.read |= A; m.write |= D; break;
+	case I_SAHF:		m.read |= bit(R_AH); break;
+	case I_LAHF:		m.read |= EFL; m.write |= bit(R_AH); break;
+	case I_SALC:		m.write |= bit(R_AL); break;
+	case I_XLAT:		m.read |= bit(R_AL) | B; m.write |= bit(R_AL); break;
+	case I_ENTER:
+	case I_LEAVE:		m.read |= BP | SP; m.write |= BP | SP; break;
+	case I_INT3:
+	case I_INT:
+	case I_INTO:
+	case I_INT1:		m.read |= SP | EFL; m.write |= SP | EFL; break;
+	case I_IRET:		m.write |= EFL; break;
+	case I_LOOPNE:
+	case I_LOOPE:		m.read |= EFL; m.read |= C; m.write |= C; break;
+	case I_LOOP:		m.read |= C; m.write |= C; break;
+	case I_JECXZ:		m.read |= C; break;
+	case I_CMC:			m.read |= EFL; break;
+	case I_CLI:
+	case I_STI:			m.write |= EFL; break;
+	case I_MUL_Eb:
+	case I_IMUL_Eb:		m.read |= bit(R_AL); m.write |= bit(R_AX); break;
+	case I_MUL_Ev:
+	case I_IMUL_Ev:		m.read |= A; m.write |= A | D; break;
+	case I_DIV_Eb:
+	case I_IDIV_Eb:		m.read |= bit(R_AX); m.write |= bit(R_AX); break;
+	case I_DIV_Ev:
+	case I_IDIV_Ev:		m.read |= A | D; m.write |= A | D; break;
+	case I_ARPL:
+	case I_LAR:
+	case I_LSL:
+	case I_VERR:
+	case I_VERW:
+	case I_RDRAND:
+	case I_RDSEED:		m.write |= EFL; break;
+	case I_WRMSR:		m.read |= A | C | D; break;
+	case I_RDTSC:		m.write |= A | D; break;
+	case I_RDMSR:
+	case I_RDPMC:		m.read |= C; m.write |= A | D; break;
+	case I_CPUID:		m.read |= A | C; m.write |= A | B | C | D; break;
+	case I_CMPXCHG_EbGb: m.read |= bit(R_AL); m.write |= bit(R_AL); break;
+	case I_CMPXCHG_EvGv: m.read |= A; m.write |= A; break;
+	case I_CMPXCHG8B:	m.read |= A | B | C | D; m.write |= A | D; break;
+	case I_ADCX:
+	case I_ADOX:		m.read |= EFL; break;
+	default:			break;
+	}
+	return m;
+}
 
-				case 0xc7: {
-						t::int8 dis;
-						if(!curs.read(dis))
-							return unknown(a, size(a));
-						t::uint32 imm;
-						if(!curs.read(imm))
-							return unknown(a, size(a));
-						return make(a, MOVI_DIS8, imm, dis, rm);
-					}
-					break;
-				}
-			}
+// close a mask pair under aliasing
+constexpr implicit_t closed(implicit_t m, const alias_t& a) {
+	implicit_t c = { 0, 0 };
+	for(int r = 0; r < R_COUNT; r++) {
+		if(m.read & bit(r))
+			c.read |= a.alias[r];
+		if(m.write & bit(r)) {
+			c.write |= a.alias[r];
+			c.read |= a.enclosing[r];
 		}
-		return unknown(a, size(a));
 	}
+	return c;
+}
 
-	///
-	t::size instSize() const override {
-		return 1;
+#define X86_IMPLICIT(id, ...)	closed(implicitOf(I_##id), ALIASES),
+#define X86_IMPLICIT64(id, ...)	closed(implicitOf(I_##id), ALIASES64),
+
+static constexpr implicit_t
+	IMPLICIT[] = { X86_INSTS(X86_IMPLICIT) },
+	IMPLICIT64[] = { X86_INSTS(X86_IMPLICIT64) };
+
+template <mode_t M>
+constexpr const implicit_t *implicits() { return M == MODE_LONG ? IMPLICIT64 : IMPLICIT; }
+
+
+/**
+ * TIMING
+ *
+ * The timing tables give, for each microarchitecture profile and each
+ * instruction form, the latency, the number of micro-operations and the
+ * usable execution ports of the register form of the instruction. They
+ * are computed at compile time from the instruction kinds and the
+ * per-form exceptions. Variable latencies are bounded by their worst case.
+ *
+ * i386: one execution unit, no micro-operation (uops = 1), cycles of the
+ * Intel 386 manual with one component for the next instruction.
+ * Atom (Bonnell): port 0 (ALU, shift, multiply, divide, store) and
+ * port 1 (ALU, branch, LEA), figures of Agner Fog's instruction tables.
+ */
+
+const t::uint8
+	P0 = 0x1,
+	P1 = 0x2,
+	P01 = P0 | P1;
+
+constexpr timing_t timingI386(int i) {
+	const Inst::kind_t k = INSTS[i].kind;
+	if(in(i, I_J8_O, I_J8_G) || in(i, I_J32_O, I_J32_G))
+		return { 8, 1, P0 };
+	else if(in(i, I_CMOV_O, I_CMOV_G) || in(i, I_SET_O, I_SET_G))
+		return { 4, 1, P0 };
+	else if(shift(i, I_RCL_EbIb) || shift(i, I_RCR_EbIb))
+		return { 9, 1, P0 };
+	switch(i) {
+	case I_MOV_EbGb: case I_MOV_EvGv: case I_MOV_GbEb: case I_MOV_GvEv:
+	case I_MOV_ZbIb: case I_MOV_ZvIz: case I_MOV_EbIb: case I_MOV_EvIz:
+	case I_MOV_EwSw: case I_LEA: case I_PUSH_Zv: case I_PUSH_Iz: case I_PUSH_Ib:
+	case I_PUSH_Ev: case I_PUSH_So: case I_CLC: case I_STC: case I_CMC:
+	case I_CLD: case I_STD: case I_LAHF: case I_CDQ:
+		return { 2, 1, P0 };
+	case I_XCHG_EbGb: case I_XCHG_EvGv: case I_XCHG_Zv: case I_CWDE: case I_SAHF:
+	case I_MOVZX_GvEb: case I_MOVZX_GvEw: case I_MOVSX_GvEb: case I_MOVSX_GvEw:
+	case I_NOP: case I_NOP_Ev: case I_CLI: case I_STI: case I_BT_EvGv: case I_BT_EvIb:
+		return { 3, 1, P0 };
+	case I_POP_Zv: case I_POP_Ev: case I_LEAVE: case I_DAA: case I_DAS: case I_AAA: case I_AAS:
+	case I_STOSB: case I_STOS:
+		return { 4, 1, P0 };
+	case I_LODSB: case I_LODS: case I_HLT:
+		return { 5, 1, P0 };
+	case I_BTS_EvGv: case I_BTR_EvGv: case I_BTC_EvGv:
+	case I_BTS_EvIb: case I_BTR_EvIb: case I_BTC_EvIb:
+		return { 6, 1, P0 };
+	case I_MOVSB: case I_MOVS: case I_SCASB: case I_SCAS:
+		return { 7, 1, P0 };
+	case I_JMP_Jz: case I_JMP_Jb: case I_CALL_Jz: case I_CALL_Ev:
+		return { 8, 1, P0 };
+	case I_CMPSB: case I_CMPS: case I_ENTER: case I_JECXZ:
+		return { 10, 1, P0 };
+	case I_RET: case I_RET_Iw: case I_JMP_Ev:
+		return { 11, 1, P0 };
+	case I_LOOP: case I_LOOPE: case I_LOOPNE:
+		return { 12, 1, P0 };
+	case I_MUL_Eb: case I_IMUL_Eb: case I_DIV_Eb:
+		return { 14, 1, P0 };
+	case I_AAM:
+		return { 17, 1, P0 };
+	case I_PUSHA: case I_AAD: case I_IDIV_Eb:
+		return { 19, 1, P0 };
+	case I_POPA:
+		return { 24, 1, P0 };
+	case I_MUL_Ev: case I_IMUL_Ev: case I_IMUL_GvEv: case I_IMUL_GvEvIz: case I_IMUL_GvEvIb:
+	case I_DIV_Ev:
+		return { 38, 1, P0 };
+	case I_IDIV_Ev:
+		return { 43, 1, P0 };
+	case I_BSF: case I_BSR:
+		return { 106, 1, P0 };
+	default:
+		return (k & Inst::IS_FLOAT) ? timing_t { 30, 1, P0 }
+			: (k & Inst::IS_TRAP) ? timing_t { 99, 1, P0 }
+			: (k & Inst::IS_CONTROL) ? timing_t { 11, 1, P0 }
+			: k == K_SHIFT ? timing_t { 3, 1, P0 }
+			: (k & Inst::IS_ALU) ? timing_t { 2, 1, P0 }
+			: (k & Inst::IS_MEM) ? timing_t { 4, 1, P0 }
+			: timing_t { 20, 1, P0 };
 	}
+}
 
-	///
-	hard::Platform * platform() const override {
-		return new Platform();
+constexpr timing_t timingAtom(int i) {
+	const Inst::kind_t k = INSTS[i].kind;
+	if(in(i, I_J8_O, I_J8_G) || in(i, I_J32_O, I_J32_G))
+		return { 1, 1, P1 };
+	else if(in(i, I_CMOV_O, I_CMOV_G) || in(i, I_SET_O, I_SET_G))
+		return { 2, 1, P01 };
+	else if(shift(i, I_RCL_EbIb) || shift(i, I_RCR_EbIb))
+		return { 7, 7, P01 };
+	switch(i) {
+	case I_JMP_Jz: case I_JMP_Jb: case I_JMP_Ev: case I_CALL_Jz: case I_CALL_Ev:
+	case I_RET: case I_RET_Iw: case I_LEA:
+		return { 1, 1, P1 };
+	case I_PUSH_Zv: case I_PUSH_Iz: case I_PUSH_Ib: case I_PUSH_Ev: case I_CDQ: case I_CWDE:
+	case I_STOSB: case I_STOS:
+		return { 1, 1, P0 };
+	case I_NOP: case I_NOP_Ev: case I_POP_Zv: case I_POP_Ev: case I_CLC: case I_STC: case I_CMC:
+		return { 1, 1, P01 };
+	case I_LEAVE: case I_JECXZ: case I_SHLD_EvGvIb: case I_SHRD_EvGvIb:
+	case I_SHLD_EvGvCL: case I_SHRD_EvGvCL:
+		return { 2, 2, P01 };
+	case I_XCHG_EbGb: case I_XCHG_EvGv: case I_XCHG_Zv: case I_MOVSB: case I_MOVS:
+	case I_LODSB: case I_LODS: case I_SCASB: case I_SCAS: case I_CMPSB: case I_CMPS:
+		return { 3, 3, P01 };
+	case I_IMUL_GvEv: case I_IMUL_GvEvIz: case I_IMUL_GvEvIb:
+		return { 5, 1, P0 };
+	case I_MUL_Ev: case I_IMUL_Ev:
+		return { 6, 3, P0 };
+	case I_MUL_Eb: case I_IMUL_Eb:
+		return { 7, 3, P0 };
+	case I_LOOP: case I_LOOPE: case I_LOOPNE:
+		return { 8, 8, P01 };
+	case I_PUSHA:
+		return { 9, 9, P01 };
+	case I_BSF: case I_BSR:
+		return { 16, 10, P01 };
+	case I_POPA: case I_ENTER:
+		return { 16, 16, P01 };
+	case I_DIV_Eb:
+		return { 22, 19, P0 };
+	case I_IDIV_Eb:
+		return { 33, 31, P0 };
+	case I_DIV_Ev:
+		return { 50, 38, P0 };
+	case I_IDIV_Ev:
+		return { 61, 45, P0 };
+	default:
+		return (k & Inst::IS_FLOAT) ? timing_t { 5, 1, P01 }
+			: (k & Inst::IS_TRAP) ? timing_t { 99, 50, P01 }
+			: (k & Inst::IS_CONTROL) ? timing_t { 1, 1, P1 }
+			: k == K_SHIFT ? timing_t { 1, 1, P0 }
+			: (k & Inst::IS_ALU) ? timing_t { 1, 1, P01 }
+			: (k & Inst::IS_MEM) ? timing_t { 1, 1, P0 }
+			: timing_t { 20, 10, P01 };
+	}
+}
+
+#define X86_TIMING_I386(id, ...)	timingI386(I_##id),
+#define X86_TIMING_ATOM(id, ...)	timingAtom(I_##id),
+
+static constexpr timing_t TIMINGS[PROFILE_COUNT][I_COUNT] = {
+	{ X86_INSTS(X86_TIMING_I386) },
+	{ X86_INSTS(X86_TIMING_ATOM) }
+};
+
+
+/**
+ * OPCODE MAPS
+ *
+ * The maps are indexed by the opcode byte and give either an instruction
+ * descriptor, a group (instruction selected by ModR/M.reg), an escape
+ * to another map, a prefix or a case requiring a special decoding.
+ */
+
+// opcode map entry flags
+const t::uint8
+	F_MODRM		= 0x01,		// ModR/M byte follows
+	F_GROUP		= 0x02,		// inst is a group
+	F_ESCAPE	= 0x04,		// escape to another map
+	F_PREFIX	= 0x08,		// legacy prefix, inst gives the prefix bits
+	F_SPECIAL	= 0x10,		// inst gives the special case
+	F_REX		= 0x20;		// REX prefix (long mode)
+
+// prefix bits
+const t::uint8
+	P_OPSIZE	= 0x01,
+	P_ADSIZE	= 0x02,
+	P_LOCK		= 0x04,
+	P_REP		= 0x08,
+	P_REPNE		= 0x10,
+	P_SEG		= 0xe0;		// segment override (segment number + 1)
+
+// REX prefix bits
+const t::uint8
+	REX_B		= 0x01,		// extension of ModR/M.rm, SIB.base or opcode register
+	REX_X		= 0x02,		// extension of SIB.index
+	REX_R		= 0x04,		// extension of ModR/M.reg
+	REX_W		= 0x08,		// 64-bit operand size
+	REX			= 0x40;		// REX present
+
+constexpr t::uint8 P_SEG_OF(int s) { return (s + 1) << 5; }
+inline int seg_of(t::uint8 prefs) { return (prefs >> 5) - 1; }
+
+// special decoding cases
+typedef enum {
+	SP_NOP,			// 90: NOP or PAUSE
+	SP_LES,			// C4: LES or 3-byte VEX
+	SP_LDS,			// C5: LDS or 2-byte VEX
+	SP_BOUND,		// 62: BOUND or EVEX
+	SP_3DNOW,		// 0F 0F
+	SP_ENDBR,		// 0F 1E: hint NOP or ENDBR32/64
+	SP_POPCNT,		// 0F B8
+	SP_TZCNT,		// 0F BC: BSF or TZCNT
+	SP_LZCNT,		// 0F BD: BSR or LZCNT
+	SP_MOVBE_LOAD,	// 0F 38 F0: MOVBE or CRC32
+	SP_MOVBE_STORE,	// 0F 38 F1: MOVBE or CRC32
+	SP_ADCX			// 0F 38 F6: ADCX or ADOX
+} special_t;
+
+// groups
+typedef enum {
+	G1_EbIb,
+	G1_EvIz,
+	G1_EvIb,
+	G1A,
+	G2_EbIb,
+	G2_EvIb,
+	G2_Eb1,
+	G2_Ev1,
+	G2_EbCL,
+	G2_EvCL,
+	G3_Eb,
+	G3_Ev,
+	G4,
+	G5,
+	G6,
+	G7,
+	G8,
+	G9,
+	G11_Eb,
+	G11_Ev,
+	G15,
+	G_COUNT
+} group_id_t;
+
+typedef struct op_t {
+	t::uint16 inst;
+	t::uint8 flags;
+} op_t;
+
+typedef struct map_t {
+	op_t ops[256];
+} map_t;
+
+typedef struct group_t {
+	t::uint16 mem[8];	// ModR/M.mod != 3
+	t::uint16 reg[8];	// ModR/M.mod == 3
+} group_t;
+
+constexpr op_t op(t::uint16 i) {
+	return { i, t::uint8(INSTS[i].layout & L_MODRM ? F_MODRM : 0) };
+}
+constexpr op_t group(t::uint16 g) { return { g, t::uint8(F_GROUP | F_MODRM) }; }
+constexpr op_t escape() { return { 0, F_ESCAPE }; }
+constexpr op_t prefix(t::uint8 p) { return { p, F_PREFIX }; }
+constexpr op_t special(t::uint16 s) { return { s, F_SPECIAL }; }
+constexpr op_t rex() { return { 0, F_REX }; }
+
+// fill n entries from opcode o with instructions starting at i
+constexpr void seq(map_t& m, int o, int n, t::uint16 i) {
+	for(int k = 0; k < n; k++)
+		m.ops[o + k] = op(i + k);
+}
+
+// fill n entries from opcode o with the same instruction i
+constexpr void fill(map_t& m, int o, int n, t::uint16 i) {
+	for(int k = 0; k < n; k++)
+		m.ops[o + k] = op(i);
+}
+
+constexpr map_t makeOneByte() {
+	map_t m = { };
+	fill(m, 0x00, 256, I_UNKNOWN);
+	seq(m, 0x00, 6, I_ADD_EbGb);
+	m.ops[0x06] = op(I_PUSH_So);
+	m.ops[0x07] = op(I_POP_So);
+	seq(m, 0x08, 6, I_OR_EbGb);
+	m.ops[0x0E] = op(I_PUSH_So);
+	m.ops[0x0F] = escape();
+	seq(m, 0x10, 6, I_ADC_EbGb);
+	m.ops[0x16] = op(I_PUSH_So);
+	m.ops[0x17] = op(I_POP_So);
+	seq(m, 0x18, 6, I_SBB_EbGb);
+	m.ops[0x1E] = op(I_PUSH_So);
+	m.ops[0x1F] = op(I_POP_So);
+	seq(m, 0x20, 6, I_AND_EbGb);
+	m.ops[0x26] = prefix(P_SEG_OF(0));
+	m.ops[0x27] = op(I_DAA);
+	seq(m, 0x28, 6, I_SUB_EbGb);
+	m.ops[0x2E] = prefix(P_SEG_OF(1));
+	m.ops[0x2F] = op(I_DAS);
+	seq(m, 0x30, 6, I_XOR_EbGb);
+	m.ops[0x36] = prefix(P_SEG_OF(2));
+	m.ops[0x37] = op(I_AAA);
+	seq(m, 0x38, 6, I_CMP_EbGb);
+	m.ops[0x3E] = prefix(P_SEG_OF(3));
+	m.ops[0x3F] = op(I_AAS);
+	fill(m, 0x40, 8, I_INC_Zv);
+	fill(m, 0x48, 8, I_DEC_Zv);
+	fill(m, 0x50, 8, I_PUSH_Zv);
+	fill(m, 0x58, 8, I_POP_Zv);
+	m.ops[0x60] = op(I_PUSHA);
+	m.ops[0x61] = op(I_POPA);
+	m.ops[0x62] = special(SP_BOUND);
+	m.ops[0x63] = op(I_ARPL);
+	m.ops[0x64] = prefix(P_SEG_OF(4));
+	m.ops[0x65] = prefix(P_SEG_OF(5));
+	m.ops[0x66] = prefix(P_OPSIZE);
+	m.ops[0x67] = prefix(P_ADSIZE);
+	seq(m, 0x68, 4, I_PUSH_Iz);
+	seq(m, 0x6C, 4, I_INSB);
+	seq(m, 0x70, 16, I_J8_O);
+	m.ops[0x80] = group(G1_EbIb);
+	m.ops[0x81] = group(G1_EvIz);
+	m.ops[0x82] = group(G1_EbIb);
+	m.ops[0x83] = group(G1_EvIb);
+	seq(m, 0x84, 11, I_TEST_EbGb);
+	m.ops[0x8F] = group(G1A);
+	m.ops[0x90] = special(SP_NOP);
+	fill(m, 0x91, 7, I_XCHG_Zv);
+	seq(m, 0x98, 24, I_CWDE);
+	fill(m, 0xB0, 8, I_MOV_ZbIb);
+	fill(m, 0xB8, 8, I_MOV_ZvIz);
+	m.ops[0xC0] = group(G2_EbIb);
+	m.ops[0xC1] = group(G2_EvIb);
+	seq(m, 0xC2, 2, I_RET_Iw);
+	m.ops[0xC4] = special(SP_LES);
+	m.ops[0xC5] = special(SP_LDS);
+	m.ops[0xC6] = group(G11_Eb);
+	m.ops[0xC7] = group(G11_Ev);
+	seq(m, 0xC8, 8, I_ENTER);
+	m.ops[0xD0] = group(G2_Eb1);
+	m.ops[0xD1] = group(G2_Ev1);
+	m.ops[0xD2] = group(G2_EbCL);
+	m.ops[0xD3] = group(G2_EvCL);
+	seq(m, 0xD4, 4, I_AAM);
+	fill(m, 0xD8, 8, I_X87);
+	seq(m, 0xE0, 16, I_LOOPNE);
+	m.ops[0xF0] = prefix(P_LOCK);
+	m.ops[0xF1] = op(I_INT1);
+	m.ops[0xF2] = prefix(P_REPNE);
+	m.ops[0xF3] = prefix(P_REP);
+	seq(m, 0xF4, 2, I_HLT);
+	m.ops[0xF6] = group(G3_Eb);
+	m.ops[0xF7] = group(G3_Ev);
+	seq(m, 0xF8, 6, I_CLC);
+	m.ops[0xFE] = group(G4);
+	m.ops[0xFF] = group(G5);
+	return m;
+}
+
+// in long mode, 40-4F are REX prefixes and some opcodes are invalid or reassigned
+constexpr map_t makeOneByte64() {
+	map_t m = makeOneByte();
+	const int invalid[] = {
+		0x06, 0x07, 0x0E, 0x16, 0x17, 0x1E, 0x1F, 0x27, 0x2F, 0x37, 0x3F,
+		0x60, 0x61, 0x82, 0x9A, 0xCE, 0xD4, 0xD5, 0xD6, 0xEA
+	};
+	for(int i = 0; i < int(sizeof(invalid) / sizeof(int)); i++)
+		m.ops[invalid[i]] = op(I_UNKNOWN);
+	for(int i = 0x40; i < 0x50; i++)
+		m.ops[i] = rex();
+	m.ops[0x63] = op(I_MOVSXD);
+	return m;
+}
+
+constexpr map_t makeTwoByte() {
+	map_t m = { };
+	fill(m, 0x00, 256, I_SSE);
+	m.ops[0x00] = group(G6);
+	m.ops[0x01] = group(G7);
+	seq(m, 0x02, 2, I_LAR);
+	m.ops[0x04] = op(I_UNKNOWN);
+	seq(m, 0x05, 5, I_SYSCALL);
+	m.ops[0x0A] = op(I_UNKNOWN);
+	m.ops[0x0B] = op(I_UD2);
+	m.ops[0x0C] = op(I_UNKNOWN);
+	seq(m, 0x0D, 2, I_PREFETCH);
+	m.ops[0x0F] = special(SP_3DNOW);
+	m.ops[0x18] = op(I_PREFETCH);
+	fill(m, 0x19, 7, I_NOP_Ev);
+	m.ops[0x1E] = special(SP_ENDBR);
+	seq(m, 0x20, 4, I_MOV_RdCd);
+	fill(m, 0x24, 4, I_UNKNOWN);
+	seq(m, 0x30, 6, I_WRMSR);
+	m.ops[0x36] = op(I_UNKNOWN);
+	m.ops[0x37] = op(I_GETSEC);
+	m.ops[0x38] = escape();
+	m.ops[0x39] = op(I_UNKNOWN);
+	m.ops[0x3A] = escape();
+	fill(m, 0x3B, 5, I_UNKNOWN);
+	seq(m, 0x40, 16, I_CMOV_O);
+	fill(m, 0x70, 4, I_SSE_IB);
+	m.ops[0x77] = op(I_EMMS);
+	fill(m, 0x78, 2, I_SYS_RM);
+	fill(m, 0x7A, 2, I_UNKNOWN);
+	seq(m, 0x80, 16, I_J32_O);
+	seq(m, 0x90, 16, I_SET_O);
+	m.ops[0xA0] = op(I_PUSH_So);
+	m.ops[0xA1] = op(I_POP_So);
+	seq(m, 0xA2, 4, I_CPUID);
+	fill(m, 0xA6, 2, I_UNKNOWN);
+	m.ops[0xA8] = op(I_PUSH_So);
+	m.ops[0xA9] = op(I_POP_So);
+	seq(m, 0xAA, 4, I_RSM);
+	m.ops[0xAE] = group(G15);
+	seq(m, 0xAF, 9, I_IMUL_GvEv);
+	m.ops[0xB8] = special(SP_POPCNT);
+	m.ops[0xB9] = op(I_UD1);
+	m.ops[0xBA] = group(G8);
+	m.ops[0xBB] = op(I_BTC_EvGv);
+	m.ops[0xBC] = special(SP_TZCNT);
+	m.ops[0xBD] = special(SP_LZCNT);
+	seq(m, 0xBE, 2, I_MOVSX_GvEb);
+	seq(m, 0xC0, 2, I_XADD_EbGb);
+	m.ops[0xC2] = op(I_SSE_IB);
+	m.ops[0xC3] = op(I_MOVNTI);
+	fill(m, 0xC4, 3, I_SSE_IB);
+	m.ops[0xC7] = group(G9);
+	fill(m, 0xC8, 8, I_BSWAP);
+	m.ops[0xFF] = op(I_UD0);
+	return m;
+}
+
+constexpr map_t makeThree38() {
+	map_t m = { };
+	fill(m, 0x00, 256, I_SSE);
+	m.ops[0xF0] = special(SP_MOVBE_LOAD);
+	m.ops[0xF1] = special(SP_MOVBE_STORE);
+	m.ops[0xF6] = special(SP_ADCX);
+	return m;
+}
+
+constexpr map_t makeThree3A() {
+	map_t m = { };
+	fill(m, 0x00, 256, I_SSE_IB);
+	return m;
+}
+
+static constexpr map_t
+	ONE_BYTE = makeOneByte(),
+	ONE_BYTE_64 = makeOneByte64(),
+	TWO_BYTE = makeTwoByte(),
+	THREE_38 = makeThree38(),
+	THREE_3A = makeThree3A();
+
+// same instruction for any ModR/M.mod
+#define X86_GROUP(i0, i1, i2, i3, i4, i5, i6, i7) \
+	{ { i0, i1, i2, i3, i4, i5, i6, i7 }, { i0, i1, i2, i3, i4, i5, i6, i7 } }
+#define X86_GROUP_ALU(F) \
+	X86_GROUP(I_ADD_##F, I_OR_##F, I_ADC_##F, I_SBB_##F, I_AND_##F, I_SUB_##F, I_XOR_##F, I_CMP_##F)
+#define X86_GROUP_SHIFT(F) \
+	X86_GROUP(I_ROL_##F, I_ROR_##F, I_RCL_##F, I_RCR_##F, I_SHL_##F, I_SHR_##F, I_SHL_##F, I_SAR_##F)
+
+static constexpr group_t GROUPS[G_COUNT] = {
+	X86_GROUP_ALU(EbIb),
+	X86_GROUP_ALU(EvIz),
+	X86_GROUP_ALU(EvIb),
+	X86_GROUP(I_POP_Ev, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM),
+	X86_GROUP_SHIFT(EbIb),
+	X86_GROUP_SHIFT(EvIb),
+	X86_GROUP_SHIFT(Eb1),
+	X86_GROUP_SHIFT(Ev1),
+	X86_GROUP_SHIFT(EbCL),
+	X86_GROUP_SHIFT(EvCL),
+	X86_GROUP(I_TEST_EbIb, I_TEST_EbIb, I_NOT_Eb, I_NEG_Eb, I_MUL_Eb, I_IMUL_Eb, I_DIV_Eb, I_IDIV_Eb),
+	X86_GROUP(I_TEST_EvIz, I_TEST_EvIz, I_NOT_Ev, I_NEG_Ev, I_MUL_Ev, I_IMUL_Ev, I_DIV_Ev, I_IDIV_Ev),
+	X86_GROUP(I_INC_Eb, I_DEC_Eb, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM),
+	X86_GROUP(I_INC_Ev, I_DEC_Ev, I_CALL_Ev, I_CALLF_Mp, I_JMP_Ev, I_JMPF_Mp, I_PUSH_Ev, I_UNKNOWN_RM),
+	X86_GROUP(I_SLDT, I_STR, I_LLDT, I_LTR, I_VERR, I_VERW, I_UNKNOWN_RM, I_UNKNOWN_RM),
+	{
+		{ I_SGDT, I_SIDT, I_LGDT, I_LIDT, I_SMSW, I_UNKNOWN_RM, I_LMSW, I_INVLPG },
+		{ I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SMSW, I_UNKNOWN_RM, I_LMSW, I_SYS_RM }
+	},
+	X86_GROUP(I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_BT_EvIb, I_BTS_EvIb, I_BTR_EvIb, I_BTC_EvIb),
+	{
+		{ I_UNKNOWN_RM, I_CMPXCHG8B, I_UNKNOWN_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM },
+		{ I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_RDRAND, I_RDSEED }
+	},
+	X86_GROUP(I_MOV_EbIb, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM),
+	X86_GROUP(I_MOV_EvIz, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM, I_UNKNOWN_RM),
+	{
+		{ I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM },
+		{ I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_SYS_RM, I_LFENCE, I_MFENCE, I_SFENCE }
 	}
+};
 
-private:
-	typedef t::uint32 arg_t;
 
-	const inst_t alu_imm(t::uint8 code) {
-		switch(code) {
-		case 5: 	return SUB32I;
-		default:	return UNKNOWN;
+/**
+ * Operands of a decoded instruction as found in the code:
+ * 	* opcode -- last opcode byte (used for register encoded in the opcode),
+ * 	* modrm, sib -- ModR/M and SIB bytes,
+ * 	* prefs -- prefix bits,
+ * 	* rex -- REX prefix (long mode only, 0 if none),
+ * 	* disp -- displacement or second immediate (ENTER, far pointer selector,
+ * 	  upper half of a 64-bit immediate or offset),
+ * 	* imm -- immediate, relative offset or absolute memory offset.
+ */
+typedef struct ops_t {
+	t::uint8 opcode;
+	t::uint8 modrm;
+	t::uint8 sib;
+	t::uint8 prefs;
+	t::uint8 rex;
+	t::int32 disp;
+	t::int32 imm;
+} ops_t;
+
+static inline t::int32 readValue(const t::uint8 *p, int size) {
+	switch(size) {
+	case 1:		return t::int8(p[0]);
+	case 2:		return t::int16(p[0] | (p[1] << 8));
+	case 4:		return t::int32(p[0] | (p[1] << 8) | (p[2] << 16) | (t::uint32(p[3]) << 24));
+	default:	return 0;
+	}
+}
+
+// immediates are never 64-bit (except MOV r64, imm64) but offsets are
+template <mode_t M>
+static inline int immSize(t::uint8 code, t::uint8 prefs) {
+	switch(code) {
+	case IMM_1:		return 1;
+	case IMM_2:		return 2;
+	case IMM_4:		return 4;
+	case IMM_V:		return prefs & P_OPSIZE ? 2 : 4;
+	case IMM_A:		return M == MODE_LONG ? (prefs & P_ADSIZE ? 4 : 8) : prefs & P_ADSIZE ? 2 : 4;
+	default:		return 0;
+	}
+}
+
+// decode SIB and displacement following a memory ModR/M (the displacement is
+// only read if vals is true), return the new position or null if the code is truncated
+// (the encoding does not depend on REX and 16-bit addressing does not exist in long mode)
+template <mode_t M>
+static const t::uint8 *decodeAddress(const t::uint8 *p, const t::uint8 *e, ops_t& ops, bool vals = true) {
+	auto mod = modrm_mod(ops.modrm), rm = modrm_rm(ops.modrm);
+	int ds = 0;
+	if(M == MODE_LONG || !(ops.prefs & P_ADSIZE)) {
+		if(rm == 4) {
+			if(p >= e)
+				return nullptr;
+			ops.sib = *p++;
+			if(mod == 0 && sib_base(ops.sib) == 5)
+				ds = 4;
 		}
+		else if(mod == 0 && rm == 5)
+			ds = 4;
+		if(mod == 1)
+			ds = 1;
+		else if(mod == 2)
+			ds = 4;
 	}
+	else {
+		if(mod == 0 && rm == 6)
+			ds = 2;
+		if(mod == 1)
+			ds = 1;
+		else if(mod == 2)
+			ds = 2;
+	}
+	if(e - p < ds)
+		return nullptr;
+	if(vals)
+		ops.disp = readValue(p, ds);
+	return p + ds;
+}
 
-	class Inst: public otawa::Inst {
-		friend class Decoder;
-	public:
+// architectural limit of the instruction length
+static const int MAX_INST_SIZE = 15;
 
-		inline Inst(Decoder& dec, gel::address_t addr, t::size size, const inst_t& inst)
-			: _dec(dec), _addr(addr), _size(size), _inst(inst), _target(nullptr) { }
+// instruction exceeding MAX_INST_SIZE: decoded as a 1-byte unknown instruction
+static inline t::uint32 tooLong(t::uint16& id, ops_t& ops) {
+	id = I_UNKNOWN;
+	ops = { 0, 0, 0, 0, 0, 0, 0 };
+	return 1;
+}
 
-		otawa::Inst::kind_t kind() override { return _inst.kind; }
-		Address address() const override { return _addr; }
-		t::uint32 size() const override { return _size; }
+// decode an instruction with VEX or EVEX prefix: only its size is computed
+template <mode_t M, bool VALS>
+static t::uint32 decodeVEX(const t::uint8 *s, const t::uint8 *p, const t::uint8 *e, t::uint8 b, t::uint16& id, ops_t& ops) {
+	int map;
+	switch(b) {
+	case 0xC5:
+		map = 1;
+		p += 1;
+		break;
+	case 0xC4:
+		if(e - p < 2)
+			return 0;
+		map = p[0] & 0x1f;
+		p += 2;
+		break;
+	default:
+		if(e - p < 3)
+			return 0;
+		map = p[0] & 0x07;
+		p += 3;
+		break;
+	}
+	if(e - p < 2)
+		return 0;
+	ops.opcode = *p++;
+	if(!(map == 1 && ops.opcode == 0x77)) {
+		ops.modrm = *p++;
+		if(modrm_mod(ops.modrm) != 3) {
+			p = decodeAddress<M>(p, e, ops, VALS);
+			if(p == nullptr)
+				return 0;
+		}
+	}
+	if(map == 3 || (map == 1 && ((ops.opcode >= 0x70 && ops.opcode <= 0x73)
+	|| ops.opcode == 0xC2 || (ops.opcode >= 0xC4 && ops.opcode <= 0xC6)))) {
+		if(p >= e)
+			return 0;
+		if(VALS)
+			ops.imm = *p;
+		p++;
+	}
+	if(p - s > MAX_INST_SIZE)
+		return tooLong(id, ops);
+	id = I_AVX;
+	return p - s;
+}
 
-		void dump(io::Output & out) override {
-			for(int p = 0; p < _inst.format.length(); p++) {
-				if(_inst.format[p] != '%')
-					out << _inst.format[p];
-				else {
-					p++;
-					int i = _inst.format[p] - '0';
-					switch(_inst.args[i]) {
-					case R32_R:
-					case R32_W:
-						out << reg32[args[i]]->name();
-						break;
-					case SIMM: {
-							t::int32 x = args[i];
-							if(x < 0) {
-								out << '-';
-								x = -x;
-							}
-							out << io::hex(x);
-						}
-						break;
-					case UIMM:
-						out << io::hex(t::uint32(args[i]));
-						break;
-					case IPREL:
-						out << "0x" << (address() + t::int32(args[i]));
-					}
-				}
+// in length-only decoding, the control instructions still get their
+// values so that their branch target is known
+static inline bool needsValues(t::uint16 id) {
+	return (INSTS[id].kind & otawa::Inst::IS_CONTROL) != 0;
+}
+
+/**
+ * Decode an instruction. The mode is a template parameter so that
+ * the tests about the mode are resolved at compile time.
+ *
+ * If VALS is false, only the length and the identifier of the instruction
+ * are computed, as well as the operand fields needed to get them (opcode,
+ * ModR/M, SIB, prefixes): the displacement and the immediates are skipped,
+ * except for the control instructions (see needsValues()).
+ *
+ * @param M		Processor mode (MODE_PROTECT or MODE_LONG).
+ * @param VALS	If true, read the displacement and the immediates.
+ * @param p		First byte of the instruction.
+ * @param e		End of the available bytes.
+ * @param id	Set to the instruction identifier.
+ * @param ops	Set to the operands.
+ * @return		Instruction size in bytes, 0 if the code is truncated
+ * 				(an instruction longer than 15 bytes gives a 1-byte I_UNKNOWN).
+ */
+template <mode_t M, bool VALS = true>
+static t::uint32 decodeInst(const t::uint8 *p, const t::uint8 *e, t::uint16& id, ops_t& ops) {
+	const t::uint8 *s = p;
+	ops = { 0, 0, 0, 0, 0, 0, 0 };
+
+	// prefixes (a REX prefix is only effective just before the opcode)
+	const map_t& one = M == MODE_LONG ? ONE_BYTE_64 : ONE_BYTE;
+	t::uint8 b;
+	op_t op;
+	while(true) {
+		if(p - s >= MAX_INST_SIZE)
+			return tooLong(id, ops);
+		if(p >= e)
+			return 0;
+		b = *p++;
+		op = one.ops[b];
+		if(!(op.flags & (F_PREFIX | F_REX)))
+			break;
+		if(M == MODE_LONG) {
+			if(op.flags & F_REX) {
+				ops.rex = b;
+				continue;
 			}
+			ops.rex = 0;
 		}
+		if(op.inst & P_SEG)
+			ops.prefs &= ~P_SEG;
+		ops.prefs |= op.inst;
+	}
 
-		void readRegSet(otawa::RegSet & set) override {
-			for(unsigned int i = 0; i < _inst.argc; i++)
-				switch(_inst.args[i]) {
-				case R32_R:
-					set.add(reg32[args[i]]->platformNumber());
-					break;
-				default:
-					break;
-				}
+	// escapes
+	if(op.flags & F_ESCAPE) {
+		if(p >= e)
+			return 0;
+		b = *p++;
+		op = TWO_BYTE.ops[b];
+		if(op.flags & F_ESCAPE) {
+			if(p >= e)
+				return 0;
+			const map_t& m = b == 0x38 ? THREE_38 : THREE_3A;
+			b = *p++;
+			op = m.ops[b];
 		}
+	}
+	ops.opcode = b;
+	t::uint16 i = op.inst;
 
-		void writeRegSet(otawa::RegSet & set) override {
-			for(unsigned int i = 0; i < _inst.argc; i++)
-				switch(_inst.args[i]) {
-				case R32_W:
-					set.add(reg32[args[i]]->platformNumber());
-					break;
-				default:
-					break;
-				}
+	// special cases
+	if(op.flags & F_SPECIAL) {
+		switch(i) {
+		case SP_NOP:
+			if(M == MODE_LONG && (ops.rex & REX_B))
+				i = I_XCHG_Zv;
+			else
+				i = ops.prefs & P_REP ? I_PAUSE : I_NOP;
+			break;
+		case SP_LES:
+		case SP_LDS:
+		case SP_BOUND:
+			if(p >= e)
+				return 0;
+			if(M == MODE_LONG || modrm_mod(*p) == 3)
+				return decodeVEX<M, VALS>(s, p, e, b, id, ops);
+			i = i == SP_LES ? I_LES : i == SP_LDS ? I_LDS : I_BOUND;
+			break;
+		case SP_3DNOW:
+			i = I_AMD3DNOW;
+			break;
+		case SP_ENDBR:
+			if(p >= e)
+				return 0;
+			if((ops.prefs & P_REP) && *p == 0xFB)
+				i = I_ENDBR32;
+			else if((ops.prefs & P_REP) && *p == 0xFA)
+				i = I_ENDBR64;
+			else
+				i = I_NOP_Ev;
+			break;
+		case SP_POPCNT:
+			i = ops.prefs & P_REP ? I_POPCNT : I_UNKNOWN_RM;
+			break;
+		case SP_TZCNT:
+			i = ops.prefs & P_REP ? I_TZCNT : I_BSF;
+			break;
+		case SP_LZCNT:
+			i = ops.prefs & P_REP ? I_LZCNT : I_BSR;
+			break;
+		case SP_MOVBE_LOAD:
+			i = ops.prefs & P_REPNE ? I_CRC32_GdEb : I_MOVBE_GvMv;
+			break;
+		case SP_MOVBE_STORE:
+			i = ops.prefs & P_REPNE ? I_CRC32_GdEv : I_MOVBE_MvGv;
+			break;
+		case SP_ADCX:
+			i = ops.prefs & P_OPSIZE ? I_ADCX : ops.prefs & P_REP ? I_ADOX : I_SSE;
+			break;
 		}
+		op.flags = INSTS[i].layout & L_MODRM ? F_MODRM : 0;
+	}
 
-		otawa::Inst *target() override {
-			if(_target == nullptr)
-				return _target;
-			for(unsigned i = 0; i < _inst.argc; i++)
-				if(_inst.args[i] == IPREL) {
-					_target = _dec.decode(_addr + t::int32(args[i]));
-					break;
-				}
-			return nullptr;
+	// ModR/M, SIB and displacement
+	t::uint8 lay;
+	if(!(op.flags & F_MODRM))
+		lay = INSTS[i].layout;
+	else {
+		if(p >= e)
+			return 0;
+		ops.modrm = *p++;
+		if(op.flags & F_GROUP) {
+			const group_t& g = GROUPS[i];
+			i = modrm_mod(ops.modrm) == 3 ? g.reg[modrm_reg(ops.modrm)] : g.mem[modrm_reg(ops.modrm)];
+		}
+		lay = INSTS[i].layout;
+		if(modrm_mod(ops.modrm) != 3 && !(lay & L_REGONLY)) {
+			p = decodeAddress<M>(p, e, ops, VALS || needsValues(i));
+			if(p == nullptr)
+				return 0;
+		}
+	}
+
+	// immediates (64-bit values are split in imm and disp)
+	if(lay & (L_IMM1 | L_IMM2)) {
+		bool vals = VALS || needsValues(i);
+		int s1 = immSize<M>(lay & L_IMM1, ops.prefs);
+		if(M == MODE_LONG && i == I_MOV_ZvIz && (ops.rex & REX_W))
+			s1 = 8;
+		if(e - p < s1)
+			return 0;
+		if(vals) {
+			if(M == MODE_LONG && s1 == 8) {
+				ops.imm = readValue(p, 4);
+				ops.disp = readValue(p + 4, 4);
+			}
+			else
+				ops.imm = readValue(p, s1);
+		}
+		p += s1;
+		int s2 = immSize<M>((lay & L_IMM2) >> 3, ops.prefs);
+		if(s2 != 0) {
+			if(e - p < s2)
+				return 0;
+			if(vals)
+				ops.disp = readValue(p, s2);
+			p += s2;
 		}
+	}
 
-	private:
-		Decoder& _dec;
-		gel::address_t _addr;
-		t::size _size;
-		const inst_t& _inst;
-		t::uint32 args[4];
-		otawa::Inst *_target;
-	};
+	if(p - s > MAX_INST_SIZE)
+		return tooLong(id, ops);
+	id = i;
+	return p - s;
+}
 
-	Inst *unknown(gel::address_t addr, t::size size) {
-		return new Inst(*this, addr, size, UNKNOWN);
+
+// operand size in bits
+template <mode_t M>
+static inline int sizeOf(const arg_t& a, const ops_t& ops) {
+	switch(a.size) {
+	case S_8:	return 8;
+	case S_16:	return 16;
+	case S_32:	return 32;
+	case S_64:	return 64;
+	case S_V:	return M == MODE_LONG && (ops.rex & REX_W) ? 64 : ops.prefs & P_OPSIZE ? 16 : 32;
+	case S_V64:	return ops.prefs & P_OPSIZE ? 16 : M == MODE_LONG ? 64 : 32;
+	case S_A:	return M == MODE_LONG ? (ops.prefs & P_ADSIZE ? 32 : 64) : ops.prefs & P_ADSIZE ? 16 : 32;
+	case S_P:	return ops.prefs & P_OPSIZE ? 32 : M == MODE_LONG && (ops.rex & REX_W) ? 80 : 48;
+	default:	return 0;
+	}
+}
+
+// encoding (0 to 15) of the general register of an argument, -1 if there is none
+template <mode_t M>
+static inline int gprCode(const arg_t& a, const ops_t& ops) {
+	int b = M == MODE_LONG && (ops.rex & REX_B) ? 8 : 0;
+	switch(a.kind) {
+	case A_REG:		return modrm_reg(ops.modrm) | (M == MODE_LONG && (ops.rex & REX_R) ? 8 : 0);
+	case A_RM:		return modrm_mod(ops.modrm) == 3 ? modrm_rm(ops.modrm) | b : -1;
+	case A_RRM:		return modrm_rm(ops.modrm) | b;
+	case A_OREG:	return (ops.opcode & 0b111) | b;
+	case A_ACC:		return 0;
+	case A_CL:		return 1;
+	case A_DX:		return 2;
+	default:		return -1;
 	}
+}
+
+// platform register of a general register by encoding and size
+// (in long mode, registers without platform register, R8D, SIL, etc,
+// are represented by their enclosing register)
+template <mode_t M>
+static inline int gpr(int n, int size, t::uint8 rex) {
+	switch(size) {
+	case 8:		return M == MODE_LONG && rex != 0 && n >= 4 ? (n < 8 ? reg16[n] : reg64[n]) : reg8[n];
+	case 16:	return M == MODE_LONG && n >= 8 ? reg64[n] : reg16[n];
+	case 64:	return reg64[n];
+	default:	return M == MODE_LONG && n >= 8 ? reg64[n] : reg32[n];
+	}
+}
 
-	inline t::size size(gel::address_t a) { return curs.offset() - (a - base); }
+// test if a general register is represented by a bigger register
+// whose other bits are kept by a write
+static inline bool isPartial(int n, int size, t::uint8 rex) {
+	return (size == 8 && rex != 0 && n >= 4) || (size == 16 && n >= 8);
+}
 
+template <mode_t M>
+static void dumpGPR(io::Output& out, int n, int size, t::uint8 rex) {
+	if(M != MODE_LONG || size == 64 || (size == 8 && rex == 0))
+		out << REGS[gpr<M>(n, size, rex)]->name();
+	else
+		out << (size == 8 ? names8 : size == 16 ? names16 : names32)[n];
+}
 
-	Inst *make(gel::address_t a, const inst_t& inst) {
-		return new Inst(*this, a, size(a), inst);
+// test if the argument is a memory access
+static inline bool isMem(const arg_t& a, const ops_t& ops) {
+	switch(a.kind) {
+	case A_RM:		return a.access != 0 && modrm_mod(ops.modrm) != 3;
+	case A_MEM:
+	case A_MOFFS:
+	case A_SRC:
+	case A_DST:		return a.access != 0;
+	default:		return false;
 	}
+}
 
-	Inst *make(gel::address_t a, const inst_t& inst, arg_t arg1) {
-		auto i = new Inst(*this, a, size(a), inst);
-		i->args[0] = arg1;
-		return i;
+// register number of the argument, -1 if there is none
+template <mode_t M>
+static int regOf(const arg_t& a, const ops_t& ops) {
+	switch(a.kind) {
+	case A_SREG:	return sreg[modrm_reg(ops.modrm)];
+	case A_OSREG:	return sreg[(ops.opcode >> 3) & 0b111];
+	default: {
+			int n = gprCode<M>(a, ops);
+			return n < 0 ? -1 : gpr<M>(n, sizeOf<M>(a, ops), ops.rex);
+		}
 	}
+}
+
+// register of the string source or destination
+template <mode_t M>
+static inline int stringReg(bool src, t::uint8 prefs) {
+	bool ad = prefs & P_ADSIZE;
+	if(M == MODE_LONG)
+		return src ? (ad ? R_ESI : R_RSI) : (ad ? R_EDI : R_RDI);
+	else
+		return src ? (ad ? R_SI : R_ESI) : (ad ? R_DI : R_EDI);
+}
 
-	Inst *make(gel::address_t a, const inst_t& inst, arg_t arg1, arg_t arg2) {
-		auto i = new Inst(*this, a, size(a), inst);
-		i->args[0] = arg1;
-		i->args[1] = arg2;
-		return i;
+// get base and index register numbers (-1 if none) of a ModR/M memory operand
+// (RIP or EIP for a RIP-relative operand)
+template <mode_t M>
+static void addrRegs(const ops_t& ops, int& base, int& index) {
+	static constexpr int base16[] = { R_BX, R_BX, R_BP, R_BP, R_SI, R_DI, R_BP, R_BX };
+	static constexpr int index16[] = { R_SI, R_DI, R_SI, R_DI, -1, -1, -1, -1 };
+	auto mod = modrm_mod(ops.modrm), rm = modrm_rm(ops.modrm);
+	base = -1;
+	index = -1;
+	if(M == MODE_LONG) {
+		int b = ops.rex & REX_B ? 8 : 0, x = ops.rex & REX_X ? 8 : 0;
+		bool ad = ops.prefs & P_ADSIZE;
+		if(rm == 4) {
+			if(!(mod == 0 && sib_base(ops.sib) == 5))
+				base = gpr<M>(sib_base(ops.sib) | b, ad ? 32 : 64, 0);
+			if((sib_index(ops.sib) | x) != 4)
+				index = gpr<M>(sib_index(ops.sib) | x, ad ? 32 : 64, 0);
+		}
+		else if(mod == 0 && rm == 5)
+			base = ad ? R_EIP : R_RIP;
+		else
+			base = gpr<M>(rm | b, ad ? 32 : 64, 0);
+	}
+	else if(ops.prefs & P_ADSIZE) {
+		if(!(mod == 0 && rm == 6))
+			base = base16[rm];
+		index = index16[rm];
+	}
+	else if(rm == 4) {
+		if(!(mod == 0 && sib_base(ops.sib) == 5))
+			base = reg32[sib_base(ops.sib)];
+		if(sib_index(ops.sib) != 4)
+			index = reg32[sib_index(ops.sib)];
+	}
+	else if(!(mod == 0 && rm == 5))
+		base = reg32[rm];
+}
+
+// compute the read and written register masks of an instruction
+template <mode_t M>
+static void masksOf(t::uint16 id, const ops_t& ops, regmask_t& read, regmask_t& write) {
+	const inst_t& d = INSTS[id];
+	const alias_t& al = aliases<M>();
+	read = implicits<M>()[id].read;
+	write = implicits<M>()[id].write;
+	bool string = false;
+	for(int i = 0; i < d.argc; i++) {
+		const arg_t& a = d.args[i];
+		if((a.kind == A_RM || a.kind == A_MEM) && modrm_mod(ops.modrm) != 3) {
+			int base, index;
+			addrRegs<M>(ops, base, index);
+			if(base >= 0)
+				read |= al.alias[base];
+			if(index >= 0)
+				read |= al.alias[index];
+		}
+		else if(a.kind == A_SRC || a.kind == A_DST) {
+			int r = stringReg<M>(a.kind == A_SRC, ops.prefs);
+			read |= al.alias[r] | al.enclosing[r];
+			write |= al.alias[r];
+			string = true;
+		}
+		else {
+			int r = regOf<M>(a, ops);
+			if(r < 0)
+				continue;
+			if(a.access & R)
+				read |= al.alias[r];
+			if(a.access & W) {
+				write |= al.alias[r];
+				read |= al.enclosing[r];
+				if(M == MODE_LONG && a.kind != A_SREG && a.kind != A_OSREG
+				&& isPartial(gprCode<M>(a, ops), sizeOf<M>(a, ops), ops.rex))
+					read |= al.alias[r];
+			}
+		}
+	}
+	if(string && (ops.prefs & (P_REP | P_REPNE))) {
+		read |= al.alias[R_ECX];
+		write |= al.alias[R_ECX];
+	}
+}
+
+// get the immediate value of argument n
+static t::int32 immOf(const inst_t& d, int n, const ops_t& ops) {
+	int k = 0;
+	for(int i = 0; i < n; i++)
+		if(immCode(d.args[i]) != IMM_NONE)
+			k++;
+	return k == 0 ? ops.imm : ops.disp;
+}
+
+// get a 64-bit immediate or offset (long mode)
+static inline t::uint64 imm64Of(const ops_t& ops) {
+	return (t::uint64(t::uint32(ops.disp)) << 32) | t::uint32(ops.imm);
+}
+
+// platform register of a fixed register of a semantic template
+template <mode_t M>
+static inline int fixedReg(int r) {
+	if(M == MODE_LONG)
+		for(int i = 0; i < 8; i++)
+			if(reg32[i] == r)
+				return reg64[i];
+	return r;
+}
+
+// semantic type of a memory access by size in bits
+static inline int semType(int size) {
+	switch(size) {
+	case 8:		return sem::UINT8;
+	case 16:	return sem::UINT16;
+	case 64:	return sem::INT64;
+	default:	return sem::INT32;
+	}
+}
+
+// test if the argument designates memory
+static inline bool inMem(const arg_t& a, const ops_t& ops) {
+	switch(a.kind) {
+	case A_RM:		return modrm_mod(ops.modrm) != 3;
+	case A_MEM:
+	case A_MOFFS:
+	case A_SRC:
+	case A_DST:		return true;
+	default:		return false;
+	}
+}
+
+/**
+ * Instantiate the semantic template of an instruction. The temporaries
+ * T1 to T3 are numbered -1 to -3, the value of argument i is in temporary
+ * -4-i and its address in temporary -7-i.
+ * @param id		Instruction descriptor.
+ * @param ops		Instruction operands.
+ * @param next		Address of the next instruction.
+ * @param write		Written registers (used without template).
+ * @param block		Block to add semantic instructions to.
+ * @return			Number of used temporaries.
+ */
+template <mode_t M>
+static int semInstsOf(t::uint16 id, const ops_t& ops, gel::address_t next, regmask_t write, sem::Block& block) {
+	const inst_t& d = INSTS[id];
+	const sem_tpl_t& tp = *d.sem;
+	if(!tp.known) {
+		for(int r = 0; r < R_COUNT; r++)
+			if(write & bit(r))
+				block.add(sem::scratch(r));
+		return 0;
+	}
+
+	// patching of the template operands
+	int vals[3], addrs[3], temps = 0;
+	auto reg = [&](int c) {
+		int r = c >= 0 ? fixedReg<M>(c) : c >= V2 ? vals[V0 - c] : c >= A2 ? addrs[A0 - c] : c - T1 - 1;
+		if(-r > temps)
+			temps = -r;
+		return r;
+	};
+	const int word = sizeOf<M>({ A_NONE, S_V64, 0 }, ops) / 8;
+
+	// prepare the used arguments
+	for(int i = 0; i < d.argc; i++) {
+		const arg_t& a = d.args[i];
+		vals[i] = -4 - i;
+		addrs[i] = -7 - i;
+		if(!(tp.uses & ((1 << i) | (8 << i))))
+			continue;
+		if(inMem(a, ops)) {
+			int ad = reg(A0 - i), v = reg(V0 - i);
+			if(a.kind == A_SRC || a.kind == A_DST)
+				addrs[i] = stringReg<M>(a.kind == A_SRC, ops.prefs);
+			else if((ops.prefs & P_SEG) && sreg[seg_of(ops.prefs)] >= R_FS)
+				block.add(sem::scratch(ad));
+			else if(a.kind == A_MOFFS)
+				block.add(sem::seti(ad, t::uint32(ops.imm)));
+			else {
+				int base, index;
+				addrRegs<M>(ops, base, index);
+				if(base == R_RIP || base == R_EIP)
+					block.add(sem::seti(ad, t::uint32(next + ops.disp)));
+				else {
+					if(base >= 0 && ops.disp == 0)
+						block.add(sem::inst(sem::SET, ad, base));
+					else {
+						block.add(sem::seti(ad, t::uint32(ops.disp)));
+						if(base >= 0)
+							block.add(sem::inst(sem::ADD, ad, ad, base));
+					}
+					if(index >= 0) {
+						int sc = M == MODE_LONG || !(ops.prefs & P_ADSIZE) ? sib_scale(ops.sib) : 0;
+						if(sc == 0)
+							block.add(sem::inst(sem::ADD, ad, ad, index));
+						else {
+							block.add(sem::seti(v, sc));
+							block.add(sem::inst(sem::SHL, v, index, v));
+							block.add(sem::inst(sem::ADD, ad, ad, v));
+						}
+					}
+				}
+			}
+			if(a.access & R)
+				block.add(sem::inst(sem::LOAD, v, addrs[i], semType(sizeOf<M>(a, ops))));
+		}
+		else {
+			int r = regOf<M>(a, ops);
+			if(r >= 0)
+				vals[i] = r;
+			else {
+				int v = reg(V0 - i);
+				switch(a.kind) {
+				case A_IMM:
+					if(M == MODE_LONG && id == I_MOV_ZvIz && (ops.rex & REX_W)
+					&& t::int64(imm64Of(ops)) != ops.imm)
+						block.add(sem::scratch(v));
+					else
+						block.add(sem::seti(v, t::uint32(immOf(d, i, ops))));
+					break;
+				case A_UIMM: {
+						t::uint32 x = immOf(d, i, ops);
+						int s = sizeOf<M>(a, ops);
+						if(s < 32)
+							x &= (1 << s) - 1;
+						block.add(sem::seti(v, x));
+					}
+					break;
+				case A_ONE:
+					block.add(sem::seti(v, 1));
+					break;
+				case A_REL:
+					block.add(sem::seti(v, t::uint32(next + ops.imm)));
+					break;
+				default:
+					block.add(sem::scratch(v));
+					break;
+				}
+			}
+		}
+	}
+
+	// instantiate the template
+	for(int k = 0; k < tp.count; k++) {
+		const sem_t& si = tp.insts[k];
+		auto op = sem::opcode(si.op);
+		switch(op) {
+		case sem::SETI:
+			block.add(sem::seti(reg(si.d), si.a == K_WORD ? word : si.a == K_NEXT ? t::uint32(next) : t::uint32(si.cst)));
+			break;
+		case sem::IF:
+			block.add(sem::_if(si.a, reg(si.d), si.b));
+			break;
+		case sem::LOAD:
+		case sem::STORE:
+			block.add(sem::inst(op, reg(si.d), reg(si.a), si.b == TY_WORD ? semType(word * 8) : si.b));
+			break;
+		case sem::TRAP:
+		case sem::CONT:
+			block.add(sem::inst(op));
+			break;
+		case sem::BRANCH:
+		case sem::SCRATCH:
+			block.add(sem::inst(op, reg(si.d)));
+			break;
+		case sem::SET:
+		case sem::NEG:
+		case sem::NOT:
+			block.add(sem::inst(op, reg(si.d), reg(si.a)));
+			break;
+		default:
+			block.add(sem::inst(op, reg(si.d), reg(si.a), reg(si.b)));
+			break;
+		}
+	}
+
+	// store back the written memory arguments
+	for(int i = 0; i < d.argc; i++) {
+		const arg_t& a = d.args[i];
+		if((tp.uses & (1 << i)) && (a.access & W) && inMem(a, ops))
+			block.add(sem::inst(sem::STORE, vals[i], addrs[i], semType(sizeOf<M>(a, ops))));
+	}
+	return temps;
+}
+
+static void dumpHex(io::Output& out, t::int32 x) {
+	if(x < 0)
+		out << "-0x" << io::hex(t::uint32(-x));
+	else
+		out << "0x" << io::hex(t::uint32(x));
+}
+
+template <mode_t M>
+static void dumpMem(io::Output& out, const arg_t& a, const ops_t& ops, int defseg) {
+	switch(sizeOf<M>(a, ops)) {
+	case 8:		out << "byte ptr "; break;
+	case 16:	out << "word ptr "; break;
+	case 32:	out << "dword ptr "; break;
+	case 48:	out << "fword ptr "; break;
+	case 64:	out << "qword ptr "; break;
+	case 80:	out << "tbyte ptr "; break;
+	default:	break;
+	}
+	int seg = ops.prefs & P_SEG ? seg_of(ops.prefs) : defseg;
+	if(seg >= 0)
+		out << REGS[sreg[seg]]->name() << ':';
+	out << '[';
+	if(a.kind == A_MOFFS) {
+		if(M == MODE_LONG && !(ops.prefs & P_ADSIZE))
+			out << "0x" << io::hex(imm64Of(ops)) << ']';
+		else
+			out << "0x" << io::hex(t::uint32(ops.imm)) << ']';
+		return;
+	}
+	int base, index;
+	addrRegs<M>(ops, base, index);
+	bool first = true;
+	if(base >= 0) {
+		out << REGS[base]->name();
+		first = false;
+	}
+	if(index >= 0) {
+		if(!first)
+			out << " + ";
+		out << REGS[index]->name();
+		if((M == MODE_LONG || !(ops.prefs & P_ADSIZE)) && sib_scale(ops.sib) != 0)
+			out << '*' << (1 << sib_scale(ops.sib));
+		first = false;
+	}
+	if(first)
+		out << "0x" << io::hex(t::uint32(ops.disp));
+	else if(ops.disp < 0)
+		out << " - 0x" << io::hex(t::uint32(-ops.disp));
+	else if(ops.disp > 0)
+		out << " + 0x" << io::hex(t::uint32(ops.disp));
+	out << ']';
+}
+
+
+/**
+ * Columnar storage of the instructions decoded in a segment. Each
+ * decoded instruction is a row made of its offset in the segment, its
+ * length, its descriptor and its packed operands, each column being stored
+ * in its own array. Rows are only appended. The register masks are not
+ * stored: they are computed from the descriptor and the operands when
+ * the instruction is queried.
+ *
+ * A partial row, produced by the length-only decoding, has only the fields
+ * of its operands used to identify the instruction: it is completed by
+ * complete() at the first access to the other fields. As the length of an
+ * instruction fits in 4 bits, the partial state is kept in the length column.
+ */
+class Store {
+public:
+	static const t::uint8 PARTIAL = 0x80;
+
+	inline t::uint32 add(t::uint32 offset, t::uint8 length, t::uint16 desc, const ops_t& ops,
+	bool partial = false) {
+		_offset.add(offset);
+		_length.add(partial ? length | PARTIAL : length);
+		_desc.add(desc);
+		_ops.add(ops);
+		return _offset.count() - 1;
+	}
+
+	inline void complete(t::uint32 row, const ops_t& ops) {
+		_ops[row] = ops;
+		_length[row] &= ~PARTIAL;
+	}
+
+	inline int count() const { return _offset.count(); }
+	inline t::uint32 offset(t::uint32 row) const { return _offset[row]; }
+	inline t::uint8 length(t::uint32 row) const { return _length[row] & ~PARTIAL; }
+	inline t::uint16 desc(t::uint32 row) const { return _desc[row]; }
+	inline const ops_t& ops(t::uint32 row) const { return _ops[row]; }
+	inline bool isPartial(t::uint32 row) const { return _length[row] & PARTIAL; }
+	inline const t::uint32 *offsets() const { return &_offset[0]; }
+	inline const t::uint8 *lengths() const { return &_length[0]; }	// only for complete rows
+	inline const t::uint16 *descs() const { return &_desc[0]; }
+	inline const ops_t *opss() const { return &_ops[0]; }
+
+	// find the first row whose offset is greater or equal to the given one
+	// (only meaningful for a store filled in increasing offset order)
+	int lowerBound(t::uint32 offset) const {
+		int l = 0, h = _offset.count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(_offset[m] < offset)
+				l = m + 1;
+			else
+				h = m;
+		}
+		return l;
+	}
+
+	t::size footprint() const {
+		return _offset.capacity() * sizeof(t::uint32)
+			+ _length.capacity() * sizeof(t::uint8)
+			+ _desc.capacity() * sizeof(t::uint16)
+			+ _ops.capacity() * sizeof(ops_t);
+	}
+
+private:
+	Vector<t::uint32> _offset;
+	Vector<t::uint8> _length;
+	Vector<t::uint16> _desc;
+	Vector<ops_t> _ops;
+};
+
+
+/**
+ * Index of the rows of a store by address. The segment is split in pages
+ * of PAGE_SIZE bytes, each one recording the rows of its instructions
+ * sorted by offset: a look-up is a binary search in the page comparing the
+ * offsets of the store, and a row costs only its number. As the rows are
+ * mostly recorded in increasing address order, recording a row usually
+ * appends it to its page.
+ */
+class RowIndex {
+public:
+	static const int PAGE_BITS = InstCache::PAGE_BITS;
+	static const t::uint32 PAGE_SIZE = InstCache::PAGE_SIZE;
+	static const t::uint32 NONE = 0xffffffff;
+
+	RowIndex(const Store& store, gel::address_t base, t::uint32 size)
+		: _store(store), _base(base), _count((size + PAGE_SIZE - 1) >> PAGE_BITS),
+		  _pages(new Vector<t::uint32> *[_count]()), _hits(0), _misses(0) { }
+
+	~RowIndex() {
+		for(t::uint32 i = 0; i < _count; i++)
+			if(_pages[i] != nullptr)
+				delete _pages[i];
+		delete [] _pages;
+	}
+
+	// get the row at the given address or NONE
+	inline t::uint32 get(gel::address_t a) const {
+		t::uint32 o = a - _base;
+		auto p = _pages[o >> PAGE_BITS];
+		if(p == nullptr)
+			return NONE;
+		int l = 0, h = p->count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(_store.offset((*p)[m]) < o)
+				l = m + 1;
+			else
+				h = m;
+		}
+		return l < p->count() && _store.offset((*p)[l]) == o ? (*p)[l] : NONE;
+	}
+
+	// same as get() but also counts the hits and the misses
+	inline t::uint32 find(gel::address_t a) {
+		t::uint32 r = get(a);
+		if(r != NONE)
+			_hits++;
+		else
+			_misses++;
+		return r;
+	}
+
+	// record a row (not already in the index)
+	inline void put(gel::address_t a, t::uint32 row) {
+		t::uint32 o = a - _base;
+		auto& p = _pages[o >> PAGE_BITS];
+		if(p == nullptr)
+			p = new Vector<t::uint32>();
+		int i = p->count();
+		p->add(row);
+		for(; i > 0 && _store.offset((*p)[i - 1]) > o; i--)
+			(*p)[i] = (*p)[i - 1];
+		(*p)[i] = row;
+	}
+
+	inline t::uint64 hits() const { return _hits; }
+	inline t::uint64 misses() const { return _misses; }
+
+	t::size footprint() const {
+		t::size s = _count * sizeof(Vector<t::uint32> *);
+		for(t::uint32 i = 0; i < _count; i++)
+			if(_pages[i] != nullptr)
+				s += sizeof(Vector<t::uint32>) + _pages[i]->capacity() * sizeof(t::uint32);
+		return s;
+	}
+
+private:
+	const Store& _store;
+	gel::address_t _base;
+	t::uint32 _count;
+	Vector<t::uint32> **_pages;
+	t::uint64 _hits, _misses;
+};
+
+
+/**
+ * Decoder class, instantiated for each supported mode (MODE_PROTECT,
+ * MODE_LONG) so that the mode tests in the decoding functions are resolved
+ * at compile time.
+ */
+template <mode_t M>
+class Decoder: public otawa::Decoder {
+public:
+
+	Decoder(gel::Image *image, bool with_stats, bool lazy)
+		: otawa::Decoder(image), base(0), top(0), avail(0), bytes(nullptr), area(nullptr),
+		  stats(with_stats ? new Stats() : nullptr), lazy(lazy) { }
+
+	~Decoder() {
+		for(auto a: areas)
+			delete a;
+		for(auto t: tables)
+			delete t;
+		if(stats != nullptr)
+			delete stats;
+	}
+
+	otawa::Inst * decode(gel::address_t a) override {
+		if(!select(a))
+			return nullptr;
+		return area->view(rowAt(a));
+	}
+
+	void decodeRange(gel::address_t start, gel::address_t end, Sink& sink) override {
+		if(!select(start))
+			return;
+		if(end > top)
+			end = top;
+		for(gel::address_t a = start; a < end;) {
+			otawa::Inst *i = area->view(rowAt(a));
+			if(i->size() == 0)
+				break;
+			sink.put(i);
+			a += i->size();
+		}
+	}
+
+	void predecode(gel::address_t start, gel::address_t end,
+	const Vector<gel::address_t>& starts, int threads) override {
+		if(!select(start))
+			return;
+		if(end > top)
+			end = top;
+		if(threads <= 0)
+			threads = std::thread::hardware_concurrency();
+		if(threads <= 0)
+			threads = 1;
+
+		// split in chunks, starting if possible on known instruction starts
+		t::uint32 csize = (end - start) / (threads * CHUNKS_PER_THREAD);
+		if(csize < MIN_CHUNK_SIZE)
+			csize = MIN_CHUNK_SIZE;
+		Vector<Chunk *> chunks;
+		for(gel::address_t a = start; a < end;) {
+			gel::address_t n = end;
+			if(end - a > csize)
+				n = knownStart(starts, a + csize, end - a > 2 * csize ? a + 2 * csize : end);
+			chunks.add(new Chunk(a - base, n - base, stats != nullptr, lazy));
+			a = n;
+		}
+
+		// decode the chunks speculatively in parallel
+		std::atomic<int> next(0);
+		auto work = [&]() {
+			for(int i = next++; i < chunks.count(); i = next++)
+				chunks[i]->decode(bytes, avail);
+		};
+		Vector<std::thread *> pool;
+		for(int i = 1; i < threads && i < chunks.count(); i++)
+			pool.add(new std::thread(work));
+		work();
+		for(auto th: pool) {
+			th->join();
+			delete th;
+		}
+
+		// stitch the chunks: resynchronize on the instruction ending the previous chunk
+		int first = area->store.count();
+		gel::address_t a = start;
+		for(auto c: chunks) {
+			const Store& cs = c->store;
+			int r = cs.lowerBound(a - base);
+			while(a < base + c->to && (r >= cs.count() || cs.offset(r) != a - base)) {
+				a += area->store.length(rowAt(a));
+				r = cs.lowerBound(a - base);
+			}
+			for(; r < cs.count(); r++) {
+				a = base + cs.offset(r);
+				if(area->rows.get(a) == RowIndex::NONE) {
+					auto row = area->store.add(cs.offset(r), cs.length(r), cs.desc(r), cs.ops(r), cs.isPartial(r));
+					area->rows.put(a, row);
+				}
+				a += cs.length(r);
+			}
+			if(c->stats != nullptr)
+				stats->add(*c->stats);
+			delete c;
+		}
+
+		// decode from the branch targets not on the linear sweep
+		for(int r = first; r < area->store.count(); r++) {
+			const inst_t& d = INSTS[area->store.desc(r)];
+			if(!(d.kind & otawa::Inst::IS_CONTROL))
+				continue;
+			for(int i = 0; i < d.argc; i++)
+				if(d.args[i].kind == A_REL) {
+					gel::address_t ta = base + area->store.offset(r) + area->store.length(r) + area->store.ops(r).imm;
+					while(ta >= start && ta < end && area->rows.get(ta) == RowIndex::NONE)
+						ta += area->store.length(rowAt(ta));
+				}
+		}
+	}
+
+	/**
+	 * Discovery working directly on the rows of the stores: the kind and
+	 * the branch target of an instruction are obtained from its descriptor
+	 * and its packed operands. The ENDBR markers found by scanEntries() are
+	 * used as additional entry points and the targets of the indirect jumps
+	 * through a bounded jump table are recovered (see resolveTable()).
+	 * A second pass explores the frame-pointer prologues not covered by the
+	 * first one.
+	 */
+	void discover(const Vector<gel::address_t>& entries, BlockTable& table) override {
+		Vector<gel::address_t> markers, prologues;
+		for(int i = 0; i < segments().count(); i++) {
+			const SegmentIndex::Entry& e = segments()[i];
+			if(e.segment()->isExecutable())
+				scanEntries(e.bytes(), e.available(), e.base(), M, &markers, &prologues);
+		}
+		for(auto e: entries)
+			table.entry(e);
+		for(auto a: markers)
+			table.entry(a);
+		explore(table);
+		table.guess(prologues);
+		explore(table);
+		table.build();
+	}
+
+	///
+	t::size instSize() const override {
+		return 1;
+	}
+
+	///
+	hard::Platform * platform() const override {
+		return Platform::shared(M);
+	}
+
+	///
+	t::size footprint() const override {
+		t::size s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->arena.footprint() + a->store.footprint()
+				   + a->rows.footprint() + a->views.footprint();
+		return s;
+	}
+
+	///
+	t::uint64 cacheHits() const override {
+		t::uint64 s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->rows.hits();
+		return s;
+	}
+
+	///
+	t::uint64 cacheMisses() const override {
+		t::uint64 s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->rows.misses();
+		return s;
+	}
+
+	///
+	string cacheId() const override {
+		return _ << (M == MODE_LONG ? "x86_64/" : "x86/") << int(CACHE_VERSION) << '/' << int(I_COUNT) << '/' << int(sizeof(ops_t));
+	}
+
+	/**
+	 * Each segment is saved as a section made of the store columns (offsets,
+	 * lengths, descriptors, operands). The partial rows are completed before.
+	 */
+	void saveCache(DecodeCache::Writer& writer) override {
+		for(auto a: areas) {
+			if(a == nullptr || a->store.count() == 0)
+				continue;
+			const Store& st = a->store;
+			t::uint32 n = st.count();
+			for(t::uint32 r = 0; r < n; r++)
+				if(st.isPartial(r))
+					a->complete(r);
+			writer.beginSection(a->base, n, CACHE_COLUMNS);
+			writer.column(st.offsets(), n * sizeof(t::uint32));
+			writer.column(st.lengths(), n * sizeof(t::uint8));
+			writer.column(st.descs(), n * sizeof(t::uint16));
+			writer.column(st.opss(), n * sizeof(ops_t));
+		}
+	}
+
+	///
+	bool dumpStats(io::Output& out) override {
+		if(stats == nullptr)
+			return false;
+		stats->dump(out, M == MODE_LONG ? "x86_64" : "x86", cacheHits(), cacheMisses());
+		return true;
+	}
+
+	///
+	bool loadCache(const DecodeCache::Reader& reader) override {
+
+		// check everything before changing the decoder
+		for(int i = 0; i < reader.count(); i++) {
+			const auto& s = reader[i];
+			auto e = segments().at(s.base());
+			t::uint32 n = s.rows();
+			if(e == nullptr || e->base() != s.base() || !e->segment()->isExecutable()
+			|| s.columns() != CACHE_COLUMNS
+			|| s.columnSize(0) != n * sizeof(t::uint32)
+			|| s.columnSize(1) != n * sizeof(t::uint8)
+			|| s.columnSize(2) != n * sizeof(t::uint16)
+			|| s.columnSize(3) != n * sizeof(ops_t))
+				return false;
+			auto offs = static_cast<const t::uint32 *>(s.column(0));
+			auto lens = static_cast<const t::uint8 *>(s.column(1));
+			auto descs = static_cast<const t::uint16 *>(s.column(2));
+			for(t::uint32 r = 0; r < n; r++)
+				if(descs[r] >= I_COUNT || lens[r] == 0 || offs[r] >= e->size() || lens[r] > e->size() - offs[r])
+					return false;
+		}
+
+		// fill the stores
+		for(int i = 0; i < reader.count(); i++) {
+			const auto& s = reader[i];
+			auto ar = areaOf(*segments().at(s.base()));
+			auto offs = static_cast<const t::uint32 *>(s.column(0));
+			auto lens = static_cast<const t::uint8 *>(s.column(1));
+			auto descs = static_cast<const t::uint16 *>(s.column(2));
+			auto ops = static_cast<const ops_t *>(s.column(3));
+			for(t::uint32 r = 0; r < s.rows(); r++) {
+				gel::address_t a = ar->base + offs[r];
+				if(ar->rows.get(a) == RowIndex::NONE)
+					ar->rows.put(a, addRow(ar->store, offs[r], lens[r], descs[r], ops[r]));
+			}
+		}
+		return true;
+	}
+
+private:
+	static const int CHUNKS_PER_THREAD = 4;
+	static const int CACHE_VERSION = 3;
+	static const int CACHE_COLUMNS = 4;
+	static const t::uint32 MIN_CHUNK_SIZE = 64 * 1024;
+	static const int HISTORY = 3;
+	static const t::uint32 MAX_TABLE = 1 << 16;
+
+	class Area;
+	class Inst;
+
+	// add a row to a store, a partial row if the operands come from a length-only
+	// decoding (the control instructions have their values in this case)
+	static t::uint32 addRow(Store& st, t::uint32 offset, t::uint8 length, t::uint16 id, const ops_t& ops,
+	bool partial = false) {
+		return st.add(offset, length, id, ops, partial && !needsValues(id));
+	}
+
+	// record a decoded instruction in the statistics
+	static void record(Stats& st, const t::uint8 *p, const t::uint8 *e, t::uint16 id, const ops_t& ops, t::uint64 ns) {
+		st.decoded(ns);
+		if(id == I_UNKNOWN || id == I_UNKNOWN_RM)
+			st.unknown(p, e, M);
+		if(ops.prefs & P_LOCK)
+			st.prefix(Stats::LOCK);
+		if(ops.prefs & P_REP)
+			st.prefix(Stats::REP);
+		if(ops.prefs & P_REPNE)
+			st.prefix(Stats::REPNE);
+		if(ops.prefs & P_SEG)
+			st.prefix(Stats::SEGMENT);
+		if(ops.prefs & P_OPSIZE)
+			st.prefix(Stats::OPSIZE);
+		if(ops.prefs & P_ADSIZE)
+			st.prefix(Stats::ADSIZE);
+		if(ops.rex != 0)
+			st.prefix(Stats::REX);
+	}
+
+	// chunk of a segment decoded by predecode() (with its own statistics
+	// as it is decoded by a worker thread)
+	class Chunk {
+	public:
+		Chunk(t::uint32 f, t::uint32 t, bool with_stats, bool lazy)
+			: from(f), to(t), stats(with_stats ? new Stats() : nullptr), lazy(lazy) { }
+		~Chunk() { if(stats != nullptr) delete stats; }
+
+		// decode linearly until the first instruction crossing the chunk end
+		// (size is the number of stored bytes, the following ones are unknown)
+		void decode(const t::uint8 *bytes, t::uint32 size) {
+			for(t::uint32 o = from; o < to;) {
+				t::uint16 id;
+				ops_t ops;
+				t::uint64 start = stats != nullptr ? Stats::now() : 0;
+				t::uint32 s = 0;
+				if(o < size)
+					s = lazy
+						? decodeInst<M, false>(bytes + o, bytes + size, id, ops)
+						: decodeInst<M>(bytes + o, bytes + size, id, ops);
+				if(s == 0) {
+					id = I_UNKNOWN;
+					ops = { 0, 0, 0, 0, 0, 0, 0 };
+					s = 1;
+				}
+				if(stats != nullptr)
+					record(*stats, bytes + o, bytes + size, id, ops, Stats::now() - start);
+				addRow(store, o, s, id, ops, lazy);
+				o += s;
+			}
+		}
+
+		t::uint32 from, to;
+		Store store;
+		Stats *stats;
+		bool lazy;
+	};
+
+	// find the first known instruction start in [a, e[ or return a
+	static gel::address_t knownStart(const Vector<gel::address_t>& starts, gel::address_t a, gel::address_t e) {
+		int l = 0, h = starts.count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(starts[m] < a)
+				l = m + 1;
+			else
+				h = m;
+		}
+		if(l < starts.count() && starts[l] < e)
+			return starts[l];
+		else
+			return a;
+	}
+
+	// test if the operands designate a memory operand [idx * 4 + disp32] and get idx
+	static bool isTableAccess(const ops_t& ops, int& idx) {
+		if(modrm_mod(ops.modrm) != 0 || modrm_rm(ops.modrm) != 4
+		|| sib_base(ops.sib) != 5 || sib_scale(ops.sib) != 2 || sib_index(ops.sib) == 4
+		|| (ops.prefs & (P_OPSIZE | P_ADSIZE)))
+			return false;
+		idx = sib_index(ops.sib);
+		return true;
+	}
+
+	// explore the pending addresses of the table
+	void explore(BlockTable& table) {
+		gel::address_t a;
+		while(table.next(a)) {
+			Area *hist_area = nullptr;
+			t::uint32 hist[HISTORY];
+			while(table.visit(a)) {
+				auto i = static_cast<Inst *>(decode(a));
+				if(i == nullptr)
+					break;
+				Area& ar = i->_area;
+				t::uint32 row = i->_row;
+				t::uint16 id = ar.store.desc(row);
+				if(id == I_UNKNOWN)
+					break;
+				if(&ar != hist_area) {
+					for(int j = 0; j < HISTORY; j++)
+						hist[j] = RowIndex::NONE;
+					hist_area = &ar;
+				}
+				const inst_t& d = INSTS[id];
+				t::uint32 s = ar.store.length(row);
+				bool branch = false;
+				gel::address_t ta = 0;
+				if(d.kind & otawa::Inst::IS_CONTROL)
+					for(int j = 0; j < d.argc; j++)
+						if(d.args[j].kind == A_REL) {
+							branch = true;
+							ta = a + s + ar.store.ops(row).imm;
+						}
+				if(M == MODE_PROTECT && id == I_JMP_Ev) {
+					JumpTable *jt = JUMP_TABLE(i);
+					if(jt == nullptr) {
+						jt = resolveTable(ar, row, hist);
+						if(jt != nullptr)
+							attach(i, jt);
+					}
+					if(jt != nullptr)
+						for(auto t: distinctTargets(*jt))
+							table.addTarget(a, t);
+				}
+				if(!table.add(i, a, s, d.kind, branch, ta))
+					break;
+				for(int j = HISTORY - 1; j > 0; j--)
+					hist[j] = hist[j - 1];
+				hist[0] = row;
+				a += s;
+			}
+		}
+	}
+
+	/**
+	 * Recover the targets of an indirect jump through a jump table as
+	 * produced by the compilers for switch statements:
+	 *		cmp idx, N
+	 *		ja default			(or jae)
+	 *		[mov r, [idx * 4 + table]]
+	 *		jmp [idx * 4 + table]	(or jmp r)
+	 * It only works on the rows of the store so that no instruction is
+	 * created for the history (see attach() to record the found table).
+	 * @param ar	Area of the jump and of its history.
+	 * @param row	Row of the indirect jump.
+	 * @param hist	Rows of the instructions preceding the jump (most recent
+	 * 				first, RowIndex::NONE if unknown).
+	 * @return		Found jump table or null.
+	 */
+	JumpTable *resolveTable(Area& ar, t::uint32 row, const t::uint32 hist[]) {
+		const ops_t& ops = ar.ops(row);
+		int p = 0, idx;
+		if(modrm_mod(ops.modrm) == 3) {
+			if(hist[0] == RowIndex::NONE || ar.store.desc(hist[0]) != I_MOV_GvEv)
+				return nullptr;
+			const ops_t& mops = ar.ops(hist[0]);
+			if(modrm_reg(mops.modrm) != modrm_rm(ops.modrm) || (ops.prefs & P_OPSIZE)
+			|| !isTableAccess(mops, idx))
+				return nullptr;
+			p = 1;
+		}
+		else if(!isTableAccess(ops, idx))
+			return nullptr;
+		gel::address_t addr = t::uint32(p == 0 ? ops.disp : ar.ops(hist[0]).disp);
+
+		// look for the bound check
+		if(hist[p] == RowIndex::NONE || hist[p + 1] == RowIndex::NONE)
+			return nullptr;
+		t::uint16 jid = ar.store.desc(hist[p]), cid = ar.store.desc(hist[p + 1]);
+		if(jid != I_J8_A && jid != I_J32_A && jid != I_J8_AE && jid != I_J32_AE)
+			return nullptr;
+		const ops_t& cops = ar.ops(hist[p + 1]);
+		if(cops.prefs & P_OPSIZE)
+			return nullptr;
+		if(cid == I_CMP_EvIb || cid == I_CMP_EvIz) {
+			if(modrm_mod(cops.modrm) != 3 || modrm_rm(cops.modrm) != idx)
+				return nullptr;
+		}
+		else if(cid != I_CMP_eAXIz || idx != 0)
+			return nullptr;
+		t::uint64 n = t::uint64(t::uint32(cops.imm)) + (jid == I_J8_A || jid == I_J32_A ? 1 : 0);
+		if(n == 0 || n > MAX_TABLE)
+			return nullptr;
+
+		// read the table
+		t::uint32 *buf = new t::uint32[n];
+		if(!segments().read(addr, buf, n)) {
+			delete [] buf;
+			return nullptr;
+		}
+		Vector<gel::address_t> targets(n);
+		for(t::uint32 j = 0; j < n; j++) {
+			auto e = segments().at(buf[j]);
+			if(e == nullptr || !e->segment()->isExecutable()) {
+				delete [] buf;
+				return nullptr;
+			}
+			targets.add(buf[j]);
+		}
+
+		// record the table
+		auto jt = new JumpTable(addr, targets);
+		tables.add(jt);
+		delete [] buf;
+		return jt;
+	}
+
+	/**
+	 * Record a jump table on its indirect jump: a JUMP_TABLE property and
+	 * a BRANCH_TARGET property for each distinct target, as read by the CFG
+	 * builder of OTAWA.
+	 * @param i		Indirect jump.
+	 * @param jt	Jump table.
+	 */
+	static void attach(Inst *i, JumpTable *jt) {
+		JUMP_TABLE(i) = jt;
+		for(auto t: distinctTargets(*jt))
+			BRANCH_TARGET(i).add(Address(t));
+	}
+
+	// get the targets of a jump table without duplicates, in increasing order
+	static Vector<gel::address_t> distinctTargets(const JumpTable& jt) {
+		Vector<gel::address_t> ts(jt.targets());
+		if(ts.count() == 0)
+			return ts;
+		std::sort(&ts[0], &ts[0] + ts.count());
+		auto top = std::unique(&ts[0], &ts[0] + ts.count());
+		ts.setLength(top - &ts[0]);
+		return ts;
+	}
+
+	/**
+	 * Try to resolve the jump table of an indirect jump when its instruction
+	 * is created by decode() or decodeRange(), so that the targets are also
+	 * available when the program is not explored by discover(). The history
+	 * is made of the already decoded rows ending just before the jump.
+	 * @param ar	Area of the jump.
+	 * @param row	Row of the indirect jump.
+	 * @return		Found jump table or null.
+	 */
+	JumpTable *resolveAt(Area& ar, t::uint32 row) {
+		t::uint32 hist[HISTORY];
+		for(int j = 0; j < HISTORY; j++)
+			hist[j] = RowIndex::NONE;
+		t::uint32 o = ar.store.offset(row);
+		for(int j = 0; j < HISTORY; j++) {
+			t::uint32 prev = RowIndex::NONE;
+			for(int k = 1; k <= MAX_INST_SIZE && k <= int(o) && prev == RowIndex::NONE; k++) {
+				t::uint32 r = ar.rows.get(ar.base + o - k);
+				if(r != RowIndex::NONE && ar.store.length(r) == k)
+					prev = r;
+			}
+			if(prev == RowIndex::NONE)
+				break;
+			hist[j] = prev;
+			o = ar.store.offset(prev);
+		}
+		return resolveTable(ar, row, hist);
+	}
+
+	// views created for the rows of a store: open-addressing hash table of
+	// the instructions keyed by their row, so that only the created views
+	// cost memory (the table is kept at most half full)
+	class ViewTable {
+	public:
+		ViewTable(): _tab(nullptr), _mask(0), _count(0) { }
+		~ViewTable() { if(_tab != nullptr) delete [] _tab; }
+
+		Inst *get(t::uint32 row) const {
+			if(_tab == nullptr)
+				return nullptr;
+			for(t::uint32 k = row & _mask; _tab[k] != nullptr; k = (k + 1) & _mask)
+				if(_tab[k]->_row == row)
+					return _tab[k];
+			return nullptr;
+		}
+
+		void put(Inst *i) {
+			if(2 * (_count + 1) > _mask + 1)
+				resize(_tab == nullptr ? 64 : 2 * (_mask + 1));
+			insert(i);
+			_count++;
+		}
+
+		t::size footprint() const { return _tab == nullptr ? 0 : (_mask + 1) * sizeof(Inst *); }
+
+	private:
+		void insert(Inst *i) {
+			t::uint32 k = i->_row & _mask;
+			while(_tab[k] != nullptr)
+				k = (k + 1) & _mask;
+			_tab[k] = i;
+		}
+
+		void resize(t::uint32 size) {
+			Inst **old = _tab;
+			t::uint32 n = _tab == nullptr ? 0 : _mask + 1;
+			_tab = new Inst *[size]();
+			_mask = size - 1;
+			for(t::uint32 k = 0; k < n; k++)
+				if(old[k] != nullptr)
+					insert(old[k]);
+			if(old != nullptr)
+				delete [] old;
+		}
+
+		Inst **_tab;
+		t::uint32 _mask, _count;
+	};
+
+	// per-segment storage of instructions
+	class Area {
+	public:
+		Area(Decoder& d, const SegmentIndex::Entry& e)
+			: decoder(d), base(e.base()), bytes(e.bytes()), avail(e.available()), rows(store, e.base(), e.size()) { }
+
+		// get the instruction of a row, its view being created at the first access
+		// (the jump tables are then resolved, see resolveAt())
+		Inst *view(t::uint32 row) {
+			Inst *i = views.get(row);
+			if(i == nullptr) {
+				i = new(arena) Inst(*this, row);
+				views.put(i);
+				if(M == MODE_PROTECT && store.desc(row) == I_JMP_Ev) {
+					JumpTable *jt = decoder.resolveAt(*this, row);
+					if(jt != nullptr)
+						attach(i, jt);
+				}
+			}
+			return i;
+		}
+
+		// access to the operands of a row, completing it if it is partial
+		inline const ops_t& ops(t::uint32 row)
+			{ if(store.isPartial(row)) complete(row); return store.ops(row); }
+
+		// decode again the instruction of a partial row with its values
+		void complete(t::uint32 row) {
+			t::uint16 id;
+			ops_t ops;
+			t::uint32 o = store.offset(row);
+			if(o >= avail || decodeInst<M>(bytes + o, bytes + avail, id, ops) == 0)
+				ops = { 0, 0, 0, 0, 0, 0, 0 };
+			store.complete(row, ops);
+		}
+
+		Decoder& decoder;
+		gel::address_t base;
+		const t::uint8 *bytes;
+		t::uint32 avail;
+		Arena arena;
+		Store store;
+		RowIndex rows;
+		ViewTable views;
+	};
+
+	// flyweight instruction over a row of the store
+	class Inst: public otawa::Inst, public RegMask, public Timed {
+		friend class Decoder;
+	public:
+
+		inline Inst(Area& area, t::uint32 row): _area(area), _row(row), _masked(false) { }
+
+		// instructions live in the arena of their segment
+		static void *operator new(std::size_t size, Arena& arena) { return arena.allocate(size, alignof(Inst)); }
+		static void operator delete(void *p, Arena& arena) { }
+		static void operator delete(void *p) { }
+
+		// only needs the ModR/M, also available in the partial rows
+		otawa::Inst::kind_t kind() override {
+			const inst_t& d = desc();
+			const ops_t& ops = _area.store.ops(_row);
+			otawa::Inst::kind_t k = d.kind;
+			for(int i = 0; i < d.argc; i++)
+				if(isMem(d.args[i], ops)) {
+					k |= IS_MEM;
+					if(d.args[i].access & R)
+						k |= IS_LOAD;
+					if(d.args[i].access & W)
+						k |= IS_STORE;
+				}
+			return k;
+		}
+
+		Address address() const override { return _area.base + _area.store.offset(_row); }
+		t::uint32 size() const override { return _area.store.length(_row); }
+
+		void dump(io::Output & out) override {
+			const inst_t& d = desc();
+			const ops_t& ops = _area.ops(_row);
+			if(ops.prefs & P_LOCK)
+				out << "lock ";
+			if((ops.prefs & (P_REP | P_REPNE)) && d.argc != 0
+			&& (d.args[0].kind == A_SRC || d.args[0].kind == A_DST))
+				out << (ops.prefs & P_REP ? "rep " : "repne ");
+			out << d.name;
+			bool first = true;
+			for(int i = 0; i < d.argc; i++) {
+				const arg_t& a = d.args[i];
+				if(a.kind == A_XRM || a.kind == A_XIB)
+					continue;
+				out << (first ? " " : ", ");
+				first = false;
+				dumpArg(out, d, i, ops);
+			}
+		}
+
+		void readRegSet(otawa::RegSet & set) override {
+			RegMask::fill(readMask(), set);
+		}
+
+		void writeRegSet(otawa::RegSet & set) override {
+			RegMask::fill(writeMask(), set);
+		}
+
+		mask_t readMask() const override { computeMasks(); return _read; }
+		mask_t writeMask() const override { computeMasks(); return _write; }
+
+		int semInsts(sem::Block& block) override {
+			return semInstsOf<M>(_area.store.desc(_row), _area.ops(_row), next(),
+				writeMask(), block);
+		}
+
+		const timing_t& timing(profile_t profile) const override {
+			return TIMINGS[profile][_area.store.desc(_row)];
+		}
+
+		otawa::Inst *target() override {
+			const inst_t& d = desc();
+			for(int i = 0; i < d.argc; i++)
+				if(d.args[i].kind == A_REL)
+					return _area.decoder.decode(next() + _area.ops(_row).imm);
+			return nullptr;
+		}
+
+	private:
+
+		inline const inst_t& desc() const { return INSTS[_area.store.desc(_row)]; }
+
+		// compute the register masks at the first query
+		inline void computeMasks() const {
+			if(!_masked) {
+				masksOf<M>(_area.store.desc(_row), _area.ops(_row), _read, _write);
+				_masked = true;
+			}
+		}
+		inline gel::address_t next() const
+			{ return _area.base + _area.store.offset(_row) + _area.store.length(_row); }
+
+		void dumpArg(io::Output& out, const inst_t& d, int i, const ops_t& ops) {
+			const arg_t& a = d.args[i];
+			switch(a.kind) {
+			case A_RM:
+			case A_MEM:
+				if(a.kind == A_MEM || modrm_mod(ops.modrm) != 3) {
+					dumpMem<M>(out, a, ops, -1);
+					break;
+				}
+				// fallthrough
+			case A_REG:
+			case A_RRM:
+			case A_OREG:
+			case A_ACC:
+			case A_CL:
+			case A_DX:
+				dumpGPR<M>(out, gprCode<M>(a, ops), sizeOf<M>(a, ops), ops.rex);
+				break;
+			case A_SREG:
+			case A_OSREG: {
+					int r = regOf<M>(a, ops);
+					if(r < 0)
+						out << "?";
+					else
+						out << REGS[r]->name();
+				}
+				break;
+			case A_CREG:
+				out << "CR" << modrm_reg(ops.modrm);
+				break;
+			case A_DREG:
+				out << "DR" << modrm_reg(ops.modrm);
+				break;
+			case A_IMM:
+				if(M == MODE_LONG && _area.store.desc(_row) == I_MOV_ZvIz && (ops.rex & REX_W))
+					out << "0x" << io::hex(imm64Of(ops));
+				else
+					dumpHex(out, immOf(d, i, ops));
+				break;
+			case A_UIMM: {
+					t::uint32 x = immOf(d, i, ops);
+					int s = sizeOf<M>(a, ops);
+					if(s < 32)
+						x &= (1 << s) - 1;
+					out << "0x" << io::hex(x);
+				}
+				break;
+			case A_ONE:
+				out << "1";
+				break;
+			case A_REL:
+				out << "0x" << io::hex(t::uint32(next() + ops.imm));
+				break;
+			case A_MOFFS:
+				dumpMem<M>(out, a, ops, -1);
+				break;
+			case A_PTR:
+				out << "0x" << io::hex(t::uint16(ops.disp)) << ":0x" << io::hex(t::uint32(ops.imm));
+				break;
+			case A_SRC:
+			case A_DST: {
+					int seg = a.kind == A_DST ? 0 : (ops.prefs & P_SEG ? seg_of(ops.prefs) : 3);
+					int r = stringReg<M>(a.kind == A_SRC, ops.prefs);
+					out << REGS[sreg[seg]]->name() << ":[" << REGS[r]->name() << ']';
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		Area& _area;
+		t::uint32 _row;
+		mutable bool _masked;
+		mutable regmask_t _read, _write;
+	};
+
+	bool select(gel::address_t a) {
+		if(bytes == nullptr || a < base || a >= top) {
+			if(stats != nullptr)
+				stats->segmentMiss();
+			auto e = segments().at(a);
+			if(e == nullptr || !e->segment()->isExecutable())
+				return false;
+			bytes = e->bytes();
+			base = e->base();
+			top = e->top();
+			avail = e->available();
+			area = areaOf(*e);
+		}
+		return true;
+	}
+
+	// get the row of the instruction at a in the current segment, decoding it if needed
+	t::uint32 rowAt(gel::address_t a) {
+		t::uint32 row = area->rows.find(a);
+		if(row == RowIndex::NONE) {
+			row = decodeAt(a);
+			area->rows.put(a, row);
+		}
+		return row;
+	}
+
+	// decode the instruction at a in the current segment and record it in the store
+	// (truncated code, or code after the stored bytes of the segment, gives a 1-byte
+	// unknown instruction so that the decoding goes on)
+	t::uint32 decodeAt(gel::address_t a) {
+		t::uint16 id;
+		ops_t ops;
+		t::uint32 o = a - base;
+		t::uint64 start = stats != nullptr ? Stats::now() : 0;
+		t::size s = 0;
+		if(o < avail)
+			s = lazy
+				? decodeInst<M, false>(bytes + o, bytes + avail, id, ops)
+				: decodeInst<M>(bytes + o, bytes + avail, id, ops);
+		if(s == 0) {
+			id = I_UNKNOWN;
+			ops = { 0, 0, 0, 0, 0, 0, 0 };
+			s = 1;
+		}
+		if(stats != nullptr)
+			record(*stats, bytes + o, bytes + avail, id, ops, Stats::now() - start);
+		return addRow(area->store, o, s, id, ops, lazy);
 	}
 
-	Inst *make(gel::address_t a, const inst_t& inst, arg_t arg1, arg_t arg2, arg_t arg3) {
-		auto i = new Inst(*this, a, size(a), inst);
-		i->args[0] = arg1;
-		i->args[1] = arg2;
-		i->args[2] = arg3;
-		return i;
+	Area *areaOf(const SegmentIndex::Entry& e) {
+		while(areas.count() <= e.index())
+			areas.add(nullptr);
+		if(areas[e.index()] == nullptr)
+			areas[e.index()] = new Area(*this, e);
+		return areas[e.index()];
 	}
 
-	gel::address_t base;
-	gel::Cursor curs;
+	gel::address_t base, top;
+	t::uint32 avail;
+	const t::uint8 *bytes;
+	Area *area;
+	Vector<Area *> areas;
+	Vector<JumpTable *> tables;
+	Stats *stats;
+	bool lazy;
 };
 
-otawa::Decoder *makeDecoder(gel::Image *i) {
-	return new Decoder(i);
+otawa::Decoder *makeDecoder(gel::Image *i, mode_t mode, bool stats, bool lazy) {
+	if(mode == MODE_LONG)
+		return new Decoder<MODE_LONG>(i, stats, lazy);
+	else
+		return new Decoder<MODE_PROTECT>(i, stats, lazy);
 }
 
 }} //otawa::x86
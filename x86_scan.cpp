@@ -0,0 +1,215 @@
+/*
+ *	otawa-x86 -- vectorized scan for function entry candidates
+ *
+ *	This file is part of x86 plug-in for OTAWA.
+ *	Copyright (c) 2021, Hugues Cassé <hug.casse@gmail.com>.
+ *
+ *	OTAWA is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	OTAWA is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with OTAWA; if not, write to the Free Software
+ *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <otawa/prog/Decoder.h>
+
+#include "x86.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define X86_SCAN_SIMD
+#	include <immintrin.h>
+#endif
+
+namespace otawa { namespace x86 {
+
+// byte pattern of at most 4 bytes
+typedef struct pattern_t {
+	int len;
+	t::uint8 bytes[4];
+} pattern_t;
+
+// searched patterns: the marker first, then the prologues (same first byte)
+static const int PATTERN_COUNT = 3;
+static const pattern_t PATTERNS32[PATTERN_COUNT] = {
+	{ 4, { 0xf3, 0x0f, 0x1e, 0xfb } },		// endbr32
+	{ 3, { 0x55, 0x89, 0xe5 } },			// push ebp; mov ebp, esp (GCC)
+	{ 3, { 0x55, 0x8b, 0xec } }				// push ebp; mov ebp, esp (MSVC)
+};
+static const pattern_t PATTERNS64[PATTERN_COUNT] = {
+	{ 4, { 0xf3, 0x0f, 0x1e, 0xfa } },		// endbr64
+	{ 4, { 0x55, 0x48, 0x89, 0xe5 } },		// push rbp; mov rbp, rsp
+	{ 4, { 0x55, 0x48, 0x8b, 0xec } }
+};
+
+// accumulation of the matches in address order
+class Matches {
+public:
+	Matches(gel::address_t base, const pattern_t *pats, Vector<gel::address_t> *markers, Vector<gel::address_t> *prologues)
+		: _base(base), _pats(pats), _markers(markers), _prologues(prologues), _last(0), _marked(false) { }
+
+	// record that pattern k matches at offset o
+	inline void put(t::uint32 o, int k) {
+		if(k == 0) {
+			if(_markers != nullptr)
+				_markers->add(_base + o);
+			_last = o;
+			_marked = true;
+		}
+		else if(_prologues != nullptr && !(_marked && o == _last + _pats[0].len))
+			_prologues->add(_base + o);
+	}
+
+	// scalar match at offset o of p (n bytes)
+	inline void scan(const t::uint8 *p, t::uint32 n, t::uint32 o) {
+		for(int k = 0; k < PATTERN_COUNT; k++) {
+			const pattern_t& pat = _pats[k];
+			if(o + pat.len > n)
+				continue;
+			int i = 0;
+			while(i < pat.len && p[o + i] == pat.bytes[i])
+				i++;
+			if(i == pat.len) {
+				put(o, k);
+				break;
+			}
+		}
+	}
+
+	inline const pattern_t& pattern(int k) const { return _pats[k]; }
+	inline t::uint8 markerByte() const { return _pats[0].bytes[0]; }
+	inline t::uint8 prologueByte() const { return _pats[1].bytes[0]; }
+
+private:
+	gel::address_t _base;
+	const pattern_t *_pats;
+	Vector<gel::address_t> *_markers, *_prologues;
+	t::uint32 _last;
+	bool _marked;
+};
+
+// scalar scan from offset o
+static void scanScalar(const t::uint8 *p, t::uint32 n, t::uint32 o, Matches& m) {
+	t::uint8 mb = m.markerByte(), pb = m.prologueByte();
+	for(; o < n; o++)
+		if(p[o] == mb || p[o] == pb)
+			m.scan(p, n, o);
+}
+
+#ifdef X86_SCAN_SIMD
+
+// record the matches of a block given the per-pattern bit masks
+static inline void putBits(t::uint32 o, t::uint32 *bits, Matches& m) {
+	t::uint32 all = bits[0] | bits[1] | bits[2];
+	while(all != 0) {
+		int j = __builtin_ctz(all);
+		all &= all - 1;
+		int k = (bits[0] >> j) & 1 ? 0 : (bits[1] >> j) & 1 ? 1 : 2;
+		m.put(o + j, k);
+	}
+}
+
+// SSE2 scan, 16 offsets per step, returns the first unscanned offset
+__attribute__((target("sse2")))
+static t::uint32 scanSSE2(const t::uint8 *p, t::uint32 n, Matches& m) {
+	__m128i c[PATTERN_COUNT][4];
+	for(int k = 0; k < PATTERN_COUNT; k++)
+		for(int i = 0; i < 4; i++)
+			c[k][i] = _mm_set1_epi8(char(m.pattern(k).bytes[i]));
+	t::uint32 o = 0;
+	for(; o + 16 + 3 <= n; o += 16) {
+		__m128i v[4];
+		v[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + o));
+		__m128i f = _mm_or_si128(_mm_cmpeq_epi8(v[0], c[0][0]), _mm_cmpeq_epi8(v[0], c[1][0]));
+		if(_mm_movemask_epi8(f) == 0)
+			continue;
+		for(int i = 1; i < 4; i++)
+			v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + o + i));
+		t::uint32 bits[PATTERN_COUNT];
+		for(int k = 0; k < PATTERN_COUNT; k++) {
+			__m128i r = _mm_cmpeq_epi8(v[0], c[k][0]);
+			for(int i = 1; i < m.pattern(k).len; i++)
+				r = _mm_and_si128(r, _mm_cmpeq_epi8(v[i], c[k][i]));
+			bits[k] = _mm_movemask_epi8(r);
+		}
+		putBits(o, bits, m);
+	}
+	return o;
+}
+
+// AVX2 scan, 32 offsets per step, returns the first unscanned offset
+__attribute__((target("avx2")))
+static t::uint32 scanAVX2(const t::uint8 *p, t::uint32 n, Matches& m) {
+	__m256i c[PATTERN_COUNT][4];
+	for(int k = 0; k < PATTERN_COUNT; k++)
+		for(int i = 0; i < 4; i++)
+			c[k][i] = _mm256_set1_epi8(char(m.pattern(k).bytes[i]));
+	t::uint32 o = 0;
+	for(; o + 32 + 3 <= n; o += 32) {
+		__m256i v[4];
+		v[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + o));
+		__m256i f = _mm256_or_si256(_mm256_cmpeq_epi8(v[0], c[0][0]), _mm256_cmpeq_epi8(v[0], c[1][0]));
+		if(_mm256_movemask_epi8(f) == 0)
+			continue;
+		for(int i = 1; i < 4; i++)
+			v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + o + i));
+		t::uint32 bits[PATTERN_COUNT];
+		for(int k = 0; k < PATTERN_COUNT; k++) {
+			__m256i r = _mm256_cmpeq_epi8(v[0], c[k][0]);
+			for(int i = 1; i < m.pattern(k).len; i++)
+				r = _mm256_and_si256(r, _mm256_cmpeq_epi8(v[i], c[k][i]));
+			bits[k] = _mm256_movemask_epi8(r);
+		}
+		putBits(o, bits, m);
+	}
+	return o;
+}
+
+#endif	// X86_SCAN_SIMD
+
+/**
+ * Scan a buffer of code for function entry candidates: the ENDBR32
+ * markers (F3 0F 1E FB) and the frame-pointer prologues
+ * push ebp; mov ebp, esp (55 89 E5 or 55 8B EC). In long mode, ENDBR64
+ * and the 64-bit prologues (55 48 89 E5 or 55 48 8B EC) are looked for.
+ * A prologue following immediately a marker is not reported as it belongs
+ * to the same function.
+ *
+ * The scan uses AVX2 or SSE2 when the host processor supports them and
+ * falls back to a scalar scan else. The candidates are only byte patterns:
+ * they may be found inside other instructions or in data.
+ *
+ * @param p			Scanned bytes.
+ * @param n			Number of bytes.
+ * @param base		Address of the first byte.
+ * @param mode		Processor mode.
+ * @param markers	If not null, receives the marker addresses in increasing order.
+ * @param prologues	If not null, receives the prologue addresses in increasing order.
+ */
+void scanEntries(
+	const t::uint8 *p,
+	t::uint32 n,
+	gel::address_t base,
+	mode_t mode,
+	Vector<gel::address_t> *markers,
+	Vector<gel::address_t> *prologues
+) {
+	Matches m(base, mode == MODE_LONG ? PATTERNS64 : PATTERNS32, markers, prologues);
+	t::uint32 o = 0;
+#	ifdef X86_SCAN_SIMD
+		if(__builtin_cpu_supports("avx2"))
+			o = scanAVX2(p, n, m);
+		else if(__builtin_cpu_supports("sse2"))
+			o = scanSSE2(p, n, m);
+#	endif
+	scanScalar(p, n, o, m);
+}
+
+}}	// otawa::x86
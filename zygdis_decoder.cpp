@@ -19,245 +19,529 @@
  *	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <elm/data/Vector.h>
+
 #include <otawa/prog/DefaultLoader.h>
 #include <otawa/hard/Platform.h>
 
+#include <otawa/prog/Arena.h>
 #include <otawa/prog/Decoder.h>
+#include <otawa/prog/InstCache.h>
 
 #include <Zydis/Zydis.h>
 #include "x86.h"
 
-namespace otawa { namespace x86 {
+namespace otawa { namespace x86 { namespace zydis {
+
+/**
+ * Compact form of a Zydis operand, recorded at decoding time so that
+ * the instruction never needs to be decoded again.
+ */
+typedef struct op_t {
+	t::uint8 type;		// ZydisOperandType
+	t::uint8 actions;	// ZydisOperandActions
+	t::uint8 flags;		// OP_xxx
+	t::uint8 scale;		// memory index scale
+	t::uint16 size;		// size in bits
+	t::uint16 reg;		// register, memory segment or pointer segment
+	t::uint16 base;		// memory base register
+	t::uint16 index;	// memory index register
+	t::int64 value;		// displacement, immediate or pointer offset
+} op_t;
+
+const t::uint8
+	OP_EXPLICIT	= 0x01,		// displayed operand
+	OP_SIGNED	= 0x02,		// signed immediate
+	OP_RELATIVE	= 0x04,		// immediate relative to next instruction
+	OP_AGEN		= 0x08,		// memory operand only used to compute an address
+	OP_SEGMENT	= 0x10;		// memory operand with segment override
+
+// prefixes
+const t::uint8
+	PREF_LOCK	= 0x01,
+	PREF_REP	= 0x02,
+	PREF_REPNE	= 0x04;
+
+// platform register numbers by Zydis register, -1 if the register is not supported
+typedef struct zregs_t {
+	t::int8 num[ZYDIS_REGISTER_MAX_VALUE + 1];
+} zregs_t;
+
+constexpr zregs_t makeZydisRegs() {
+	zregs_t z = { { 0 } };
+	t::int8 *n = z.num;
+	for(int i = 0; i <= ZYDIS_REGISTER_MAX_VALUE; i++)
+		n[i] = -1;
+	n[ZYDIS_REGISTER_AL] = R_AL;
+	n[ZYDIS_REGISTER_CL] = R_CL;
+	n[ZYDIS_REGISTER_DL] = R_DL;
+	n[ZYDIS_REGISTER_BL] = R_BL;
+	n[ZYDIS_REGISTER_AH] = R_AH;
+	n[ZYDIS_REGISTER_CH] = R_CH;
+	n[ZYDIS_REGISTER_DH] = R_DH;
+	n[ZYDIS_REGISTER_BH] = R_BH;
+	n[ZYDIS_REGISTER_AX] = R_AX;
+	n[ZYDIS_REGISTER_CX] = R_CX;
+	n[ZYDIS_REGISTER_DX] = R_DX;
+	n[ZYDIS_REGISTER_BX] = R_BX;
+	n[ZYDIS_REGISTER_SP] = R_SP;
+	n[ZYDIS_REGISTER_BP] = R_BP;
+	n[ZYDIS_REGISTER_SI] = R_SI;
+	n[ZYDIS_REGISTER_DI] = R_DI;
+	n[ZYDIS_REGISTER_EAX] = R_EAX;
+	n[ZYDIS_REGISTER_ECX] = R_ECX;
+	n[ZYDIS_REGISTER_EDX] = R_EDX;
+	n[ZYDIS_REGISTER_EBX] = R_EBX;
+	n[ZYDIS_REGISTER_ESP] = R_ESP;
+	n[ZYDIS_REGISTER_EBP] = R_EBP;
+	n[ZYDIS_REGISTER_ESI] = R_ESI;
+	n[ZYDIS_REGISTER_EDI] = R_EDI;
+	n[ZYDIS_REGISTER_ES] = R_ES;
+	n[ZYDIS_REGISTER_CS] = R_CS;
+	n[ZYDIS_REGISTER_SS] = R_SS;
+	n[ZYDIS_REGISTER_DS] = R_DS;
+	n[ZYDIS_REGISTER_FS] = R_FS;
+	n[ZYDIS_REGISTER_GS] = R_GS;
+	n[ZYDIS_REGISTER_FLAGS] = R_EFLAGS;
+	n[ZYDIS_REGISTER_EFLAGS] = R_EFLAGS;
+	n[ZYDIS_REGISTER_IP] = R_IP;
+	n[ZYDIS_REGISTER_EIP] = R_EIP;
+
+	// long mode: the registers without platform register are represented
+	// by their enclosing register
+	const int r64[] = { R_RAX, R_RCX, R_RDX, R_RBX, R_RSP, R_RBP, R_RSI, R_RDI };
+	for(int i = 0; i < 8; i++) {
+		n[ZYDIS_REGISTER_RAX + i] = r64[i];
+		n[ZYDIS_REGISTER_R8 + i] = R_R8 + i;
+		n[ZYDIS_REGISTER_R8D + i] = R_R8 + i;
+		n[ZYDIS_REGISTER_R8W + i] = R_R8 + i;
+		n[ZYDIS_REGISTER_R8B + i] = R_R8 + i;
+	}
+	n[ZYDIS_REGISTER_SPL] = R_SP;
+	n[ZYDIS_REGISTER_BPL] = R_BP;
+	n[ZYDIS_REGISTER_SIL] = R_SI;
+	n[ZYDIS_REGISTER_DIL] = R_DI;
+	n[ZYDIS_REGISTER_RFLAGS] = R_EFLAGS;
+	n[ZYDIS_REGISTER_RIP] = R_RIP;
+	return z;
+}
+
+static constexpr zregs_t ZYDIS_REGS = makeZydisRegs();
+
+static inline int decodeReg(t::uint16 r) {
+	return r <= ZYDIS_REGISTER_MAX_VALUE ? ZYDIS_REGS.num[r] : -1;
+}
+
+static void dumpHex(io::Output& out, t::int64 x) {
+	if(x < 0)
+		out << "-0x" << io::hex(t::uint64(-x));
+	else
+		out << "0x" << io::hex(t::uint64(x));
+}
+
+// kind of an instruction from its Zydis category
+static Inst::kind_t kindOf(const ZydisDecodedInstruction& zi) {
+	switch(zi.meta.category) {
+	case ZYDIS_CATEGORY_COND_BR:	return Inst::IS_CONTROL | Inst::IS_COND;
+	case ZYDIS_CATEGORY_UNCOND_BR:	return Inst::IS_CONTROL;
+	case ZYDIS_CATEGORY_CALL:		return Inst::IS_CONTROL | Inst::IS_CALL;
+	case ZYDIS_CATEGORY_RET:
+	case ZYDIS_CATEGORY_SYSRET:		return Inst::IS_CONTROL | Inst::IS_RETURN;
+	case ZYDIS_CATEGORY_INTERRUPT:
+	case ZYDIS_CATEGORY_SYSCALL:	return Inst::IS_CONTROL | Inst::IS_TRAP;
+	case ZYDIS_CATEGORY_SYSTEM:
+	case ZYDIS_CATEGORY_IO:
+	case ZYDIS_CATEGORY_NOP:
+	case ZYDIS_CATEGORY_WIDENOP:
+	case ZYDIS_CATEGORY_PREFETCH:
+	case ZYDIS_CATEGORY_CET:		return Inst::IS_INTERN;
+	case ZYDIS_CATEGORY_X87_ALU:
+	case ZYDIS_CATEGORY_FCMOV:		return Inst::IS_FLOAT;
+	case ZYDIS_CATEGORY_SHIFT:
+	case ZYDIS_CATEGORY_ROTATE:		return Inst::IS_ALU | Inst::IS_INT | Inst::IS_SHIFT;
+	case ZYDIS_CATEGORY_CMOV:		return Inst::IS_ALU | Inst::IS_INT | Inst::IS_COND;
+	case ZYDIS_CATEGORY_BINARY:
+		switch(zi.mnemonic) {
+		case ZYDIS_MNEMONIC_MUL:
+		case ZYDIS_MNEMONIC_IMUL:	return Inst::IS_ALU | Inst::IS_INT | Inst::IS_MUL;
+		case ZYDIS_MNEMONIC_DIV:
+		case ZYDIS_MNEMONIC_IDIV:	return Inst::IS_ALU | Inst::IS_INT | Inst::IS_DIV;
+		default:					return Inst::IS_ALU | Inst::IS_INT;
+		}
+	case ZYDIS_CATEGORY_LOGICAL:
+	case ZYDIS_CATEGORY_BITBYTE:
+	case ZYDIS_CATEGORY_FLAGOP:
+	case ZYDIS_CATEGORY_DATAXFER:
+	case ZYDIS_CATEGORY_CONVERT:
+	case ZYDIS_CATEGORY_DECIMAL:
+	case ZYDIS_CATEGORY_SETCC:
+	case ZYDIS_CATEGORY_STRINGOP:
+	case ZYDIS_CATEGORY_PUSH:
+	case ZYDIS_CATEGORY_POP:
+	case ZYDIS_CATEGORY_SEMAPHORE:	return Inst::IS_ALU | Inst::IS_INT;
+	default:						return 0;
+	}
+}
+
 
 // Decoder class
 class Decoder: public otawa::Decoder {
 public:
 
-	class BaseInst: public Inst {
+	// instruction in compact decoded form
+	class Inst: public otawa::Inst {
 	public:
-		BaseInst(Decoder& decoder, Address addr, t::size size, kind_t kind)
-			: dec(decoder), a(addr.offset()), s(size), k(kind) { }
+		Inst(Decoder& decoder, gel::address_t addr, t::uint8 size, kind_t kind,
+			t::uint16 mnemonic, t::uint8 prefs, t::uint8 count, op_t *ops)
+		: dec(decoder), a(addr), k(kind), m(mnemonic), s(size), p(prefs), c(count), o(ops) { }
+
+		// instructions live in the arena of their segment
+		static void *operator new(std::size_t size, Arena& arena) { return arena.allocate(size, alignof(Inst)); }
+		static void operator delete(void *p, Arena& arena) { }
+		static void operator delete(void *p) { }
 		Address address() const override { return a; }
 		t::uint32 size() const override { return s; }
 		kind_t kind() override { return k; }
 
 		void dump(io::Output &out) override {
-			//cerr << io::hex(a) << ':' << s << io::endl;
-			auto r = dec.decodeRaw(a);
-			ASSERT(r);
-			char buffer[256];
-			ZydisFormatterFormatInstruction(&dec.zform, &dec.zi, buffer, sizeof(buffer), a);
-			out << buffer;
+			if(p & PREF_LOCK)
+				out << "lock ";
+			if(p & PREF_REP)
+				out << "rep ";
+			if(p & PREF_REPNE)
+				out << "repne ";
+			if(m == ZYDIS_MNEMONIC_INVALID) {
+				out << "unknown";
+				return;
+			}
+			out << ZydisMnemonicGetString(ZydisMnemonic(m));
+			bool first = true;
+			for(int i = 0; i < c; i++)
+				if(o[i].flags & OP_EXPLICIT) {
+					out << (first ? " " : ", ");
+					first = false;
+					dumpOp(out, o[i]);
+				}
 		}
 
-	protected:
-		Decoder &dec;
-		t::uint32 a;
-		t::uint32 s;
-		kind_t k;
-	};
+		void readRegSet(otawa::RegSet & set) override {
+			for(int i = 0; i < c; i++)
+				switch(o[i].type) {
+				case ZYDIS_OPERAND_TYPE_REGISTER:
+					if(o[i].actions & ZYDIS_OPERAND_ACTION_MASK_READ)
+						add(set, o[i].reg);
+					break;
+				case ZYDIS_OPERAND_TYPE_MEMORY:
+					add(set, o[i].base);
+					add(set, o[i].index);
+					break;
+				default:
+					break;
+				}
+		}
 
-	class Branch: public BaseInst {
-	public:
-		Branch(Decoder& decoder, Address addr, t::size size, kind_t kind, t::int32 off): BaseInst(decoder, addr, size, kind), o(off), t(nullptr) { }
-		Inst *target() override {
-			if(getKind().isIndirect())
-				return nullptr;
-			else if(t == nullptr)
-				t = dec.decode(a + s + o);
-			return t;
+		void writeRegSet(otawa::RegSet & set) override {
+			for(int i = 0; i < c; i++)
+				if(o[i].type == ZYDIS_OPERAND_TYPE_REGISTER
+				&& (o[i].actions & ZYDIS_OPERAND_ACTION_MASK_WRITE))
+					add(set, o[i].reg);
 		}
-	private:
-		t::int32 o;
-		Inst *t;
-	};
 
-	Decoder(gel::Image *i): otawa::Decoder(i) {
-		ZydisDecoderInit(&zdec, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_ADDRESS_WIDTH_32);
-		ZydisFormatterInit(&zform, ZYDIS_FORMATTER_STYLE_INTEL);
-	}
+		otawa::Inst *target() override {
+			if(c == 0 || (k & IS_INDIRECT)
+			|| o[0].type != ZYDIS_OPERAND_TYPE_IMMEDIATE || !(o[0].flags & OP_RELATIVE))
+				return nullptr;
+			return dec.decode(a + s + o[0].value);
+		}
 
-	Inst *decode(gel::address_t a) override {
-		if(!decodeRaw(a))
-			return nullptr;
+	private:
 
-		// compute kind
-		Inst *inst = nullptr;
-		Inst::kind_t k = 0;
-		switch(zi.mnemonic) {
+		// an absolute address (sign-extended by Zydis) in the address width of the mode
+		inline t::uint64 absolute(t::int64 x) const {
+			return dec._mode == MODE_LONG ? t::uint64(x) : t::uint64(t::uint32(x));
+		}
 
-		// relative branchers
-		// target = topAddress() + operands[0].imm
-		case ZYDIS_MNEMONIC_JMP:
-			k = Inst::IS_CONTROL;
-			goto branch;
-		case ZYDIS_MNEMONIC_JB:		// ULT
-		case ZYDIS_MNEMONIC_JBE:	// ULE
-		case ZYDIS_MNEMONIC_JCXZ:	// CX = 0
-		case ZYDIS_MNEMONIC_JECXZ:	// ???
-		case ZYDIS_MNEMONIC_JKNZD:	// ???
-		case ZYDIS_MNEMONIC_JKZD:	// ???
-		case ZYDIS_MNEMONIC_JL:		// LT
-		case ZYDIS_MNEMONIC_JLE:	// LE
-		case ZYDIS_MNEMONIC_JNB:	// UGE
-		case ZYDIS_MNEMONIC_JNBE:	// UGT
-		case ZYDIS_MNEMONIC_JNL:	// GE
-		case ZYDIS_MNEMONIC_JNLE:	// GT
-		case ZYDIS_MNEMONIC_JNO:	// not overflow
-		case ZYDIS_MNEMONIC_JNP:	// parity odd
-		case ZYDIS_MNEMONIC_JNS:	// positive
-		case ZYDIS_MNEMONIC_JNZ:	// NE
-		case ZYDIS_MNEMONIC_JO:		// overflow
-		case ZYDIS_MNEMONIC_JP:		// parity
-		case ZYDIS_MNEMONIC_JRCXZ:	// ???
-		case ZYDIS_MNEMONIC_JS:		// negative
-		case ZYDIS_MNEMONIC_JZ:		// EQ
-			k = Inst::IS_CONTROL | Inst::IS_COND;
-			goto branch;
-
-		case ZYDIS_MNEMONIC_RET:
-			k = Inst::IS_RETURN | Inst::IS_CONTROL;
-			goto normal;
-
-		branch:
-			if(zi.operands[0].type != ZYDIS_OPERAND_TYPE_IMMEDIATE)
-				inst = new Branch(*this, a, zi.length, k | Inst::IS_INDIRECT, 0);
-			else
-				inst = new Branch(*this, a, zi.length, k, zi.operands[0].imm.value.s);
-			break;
-
-		default:
-		normal:
-			inst = new BaseInst(*this, a, zi.length, k);
-			break;
+		static void add(otawa::RegSet& set, t::uint16 r) {
+			int n = decodeReg(r);
+			if(n >= 0)
+				set.add(n);
 		}
 
-		// dump operands (for debugging)
-#		if 0
-		cerr << "DEBUG: instr @" << io::hex(a) << ": " << static_cast<otawa::Inst *>(inst) << io::endl;
-		for(int i = 0; i < zi.operand_count; i++) {
-			cerr << "DEBUG: operand " << i << " (" << int(zi.operands[i].type) << "): ";
-			switch(zi.operands[i].type) {
-			case ZYDIS_OPERAND_TYPE_REGISTER: {
-					auto r = decodeReg(zi.operands[i].reg.value);
-					if(r != nullptr)
-						cerr << r->name();
-					cerr << " (" << int(zi.operands[i].reg.value) << ")";
-				}
+		void dumpOp(io::Output& out, const op_t& op) {
+			switch(op.type) {
+			case ZYDIS_OPERAND_TYPE_REGISTER:
+				out << ZydisRegisterGetString(ZydisRegister(op.reg));
 				break;
 			case ZYDIS_OPERAND_TYPE_MEMORY: {
-					cerr << "[";
-					auto r = decodeReg(zi.operands[i].mem.segment);
-					if(r != nullptr)
-						cerr << r->name() << ":";
-					else
-						cerr << int(zi.operands[i].mem.segment) << ":";
-					r = decodeReg(zi.operands[i].mem.base);
-					if(r != nullptr)
-						cerr << r->name();
-					else
-						cerr << int(zi.operands[i].mem.base);
-					if(zi.operands[i].mem.index != ZYDIS_REGISTER_NONE) {
-						r = decodeReg(zi.operands[i].mem.index);
-						if(r != nullptr)
-							cerr << " + " << r->name();
-						else
-							cerr << " + " << int(zi.operands[i].mem.index);
-						if(zi.operands[i].mem.scale != 0)
-							cerr << "*" << zi.operands[i].mem.scale;
+					if(!(op.flags & OP_AGEN))
+						switch(op.size) {
+						case 8:		out << "byte ptr "; break;
+						case 16:	out << "word ptr "; break;
+						case 32:	out << "dword ptr "; break;
+						case 48:	out << "fword ptr "; break;
+						case 64:	out << "qword ptr "; break;
+						case 80:	out << "tbyte ptr "; break;
+						case 128:	out << "xmmword ptr "; break;
+						case 256:	out << "ymmword ptr "; break;
+						case 512:	out << "zmmword ptr "; break;
+						default:	break;
+						}
+					if(op.flags & OP_SEGMENT)
+						out << ZydisRegisterGetString(ZydisRegister(op.reg)) << ':';
+					out << '[';
+					bool first = true;
+					if(op.base != ZYDIS_REGISTER_NONE) {
+						out << ZydisRegisterGetString(ZydisRegister(op.base));
+						first = false;
+					}
+					if(op.index != ZYDIS_REGISTER_NONE) {
+						if(!first)
+							out << " + ";
+						out << ZydisRegisterGetString(ZydisRegister(op.index));
+						if(op.scale > 1)
+							out << '*' << op.scale;
+						first = false;
 					}
-					if(zi.operands[i].mem.disp.value != 0)
-						cerr << " + " << zi.operands[i].mem.disp.value;
-					cerr << "]";
+					if(first)
+						out << "0x" << io::hex(absolute(op.value));
+					else if(op.value < 0)
+						out << " - 0x" << io::hex(t::uint64(-op.value));
+					else if(op.value > 0)
+						out << " + 0x" << io::hex(t::uint64(op.value));
+					out << ']';
 				}
 				break;
 			case ZYDIS_OPERAND_TYPE_POINTER:
+				out << "0x" << io::hex(op.reg) << ":0x" << io::hex(absolute(op.value));
 				break;
 			case ZYDIS_OPERAND_TYPE_IMMEDIATE:
-				if(zi.operands[i].imm.is_signed)
-					cerr << io::hex(zi.operands[i].imm.value.s);
+				if(op.flags & OP_RELATIVE)
+					out << "0x" << io::hex(a + s + op.value);
+				else if(op.flags & OP_SIGNED)
+					dumpHex(out, op.value);
 				else
-					cerr << io::hex(zi.operands[i].imm.value.u);
+					out << "0x" << io::hex(t::uint64(op.value));
 				break;
 			default:
 				break;
 			}
-			switch(zi.operands[i].visibility) {
-			case ZYDIS_OPERAND_VISIBILITY_EXPLICIT: cerr << " +"; break;
-			case ZYDIS_OPERAND_VISIBILITY_IMPLICIT: cerr << " ~"; break;
-			case ZYDIS_OPERAND_VISIBILITY_HIDDEN:   cerr << " -"; break;
-			default:								cerr << " ?"; break;
+		}
+
+		Decoder &dec;
+		gel::address_t a;
+		kind_t k;
+		t::uint16 m;
+		t::uint8 s, p, c;
+		op_t *o;
+	};
+
+	Decoder(gel::Image *i, mode_t mode, bool with_stats)
+	: otawa::Decoder(i), _mode(mode), area(nullptr), stats(with_stats ? new Stats() : nullptr) {
+		if(mode == MODE_LONG)
+			ZydisDecoderInit(&zdec, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_ADDRESS_WIDTH_64);
+		else
+			ZydisDecoderInit(&zdec, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_ADDRESS_WIDTH_32);
+	}
+
+	~Decoder() {
+		for(auto a: areas)
+			delete a;
+		if(stats != nullptr)
+			delete stats;
+	}
+
+	otawa::Inst *decode(gel::address_t a) override {
+		auto e = select(a);
+		if(e == nullptr)
+			return nullptr;
+		auto c = area->cache.find(a);
+		if(c != nullptr)
+			return c;
+		ZydisDecodedInstruction zi;
+		t::uint64 start = stats != nullptr ? Stats::now() : 0;
+		bool done = decodeRaw(*e, a, zi);
+		if(stats != nullptr)
+			record(*e, a, done, zi, Stats::now() - start);
+		if(!done) {
+			// undecodable bytes give a 1-byte unknown instruction, as in the x86 engine
+			auto inst = new(area->arena) Inst(*this, a, 1, 0, ZYDIS_MNEMONIC_INVALID, 0, 0, nullptr);
+			area->cache.put(a, inst);
+			return inst;
+		}
+
+		// record the operands
+		op_t *ops = nullptr;
+		Inst::kind_t k = kindOf(zi);
+		if(zi.operand_count != 0)
+			ops = static_cast<op_t *>(area->arena.allocate(zi.operand_count * sizeof(op_t), alignof(op_t)));
+		for(int i = 0; i < zi.operand_count; i++) {
+			const ZydisDecodedOperand& zo = zi.operands[i];
+			op_t& op = ops[i];
+			op = { t::uint8(zo.type), t::uint8(zo.actions), 0, 0, zo.size, 0, 0, 0, 0 };
+			if(zo.visibility == ZYDIS_OPERAND_VISIBILITY_EXPLICIT)
+				op.flags |= OP_EXPLICIT;
+			switch(zo.type) {
+			case ZYDIS_OPERAND_TYPE_REGISTER:
+				op.reg = zo.reg.value;
+				break;
+			case ZYDIS_OPERAND_TYPE_MEMORY:
+				op.reg = zo.mem.segment;
+				op.base = zo.mem.base;
+				op.index = zo.mem.index;
+				op.scale = zo.mem.scale;
+				op.value = zo.mem.disp.has_displacement ? zo.mem.disp.value : 0;
+				if(zo.mem.type == ZYDIS_MEMOP_TYPE_AGEN)
+					op.flags |= OP_AGEN;
+				else {
+					if(zo.actions & ZYDIS_OPERAND_ACTION_MASK_READ)
+						k |= Inst::IS_MEM | Inst::IS_LOAD;
+					if(zo.actions & ZYDIS_OPERAND_ACTION_MASK_WRITE)
+						k |= Inst::IS_MEM | Inst::IS_STORE;
+				}
+				if(zi.attributes & ZYDIS_ATTRIB_HAS_SEGMENT)
+					op.flags |= OP_SEGMENT;
+				break;
+			case ZYDIS_OPERAND_TYPE_POINTER:
+				op.reg = zo.ptr.segment;
+				op.value = zo.ptr.offset;
+				break;
+			case ZYDIS_OPERAND_TYPE_IMMEDIATE:
+				op.value = zo.imm.value.s;
+				if(zo.imm.is_signed)
+					op.flags |= OP_SIGNED;
+				if(zo.imm.is_relative)
+					op.flags |= OP_RELATIVE;
+				break;
+			default:
+				break;
 			}
-			cerr << io::endl;
 		}
-		cerr << io::endl;
-#		endif
 
+		// indirect branches
+		if((k & Inst::IS_CONTROL) && !(k & (Inst::IS_RETURN | Inst::IS_TRAP))
+		&& (zi.operand_count == 0 || zi.operands[0].type != ZYDIS_OPERAND_TYPE_IMMEDIATE))
+			k |= Inst::IS_INDIRECT;
+
+		// build the instruction
+		t::uint8 prefs = 0;
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_LOCK)
+			prefs |= PREF_LOCK;
+		if(zi.attributes & (ZYDIS_ATTRIB_HAS_REP | ZYDIS_ATTRIB_HAS_REPE))
+			prefs |= PREF_REP;
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_REPNE)
+			prefs |= PREF_REPNE;
+		auto inst = new(area->arena) Inst(*this, a, zi.length, k, zi.mnemonic, prefs, zi.operand_count, ops);
+		area->cache.put(a, inst);
 		return inst;
 	}
 
 	t::size instSize() const override { return 1; }
-	hard::Platform *platform() const override { return new Platform(); }
+	hard::Platform *platform() const override { return Platform::shared(_mode); }
+
+	t::size footprint() const override {
+		t::size s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->arena.footprint();
+		return s;
+	}
+
+	t::uint64 cacheHits() const override {
+		t::uint64 s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->cache.hits();
+		return s;
+	}
+
+	t::uint64 cacheMisses() const override {
+		t::uint64 s = 0;
+		for(auto a: areas)
+			if(a != nullptr)
+				s += a->cache.misses();
+		return s;
+	}
+
+	bool dumpStats(io::Output& out) override {
+		if(stats == nullptr)
+			return false;
+		stats->dump(out, "zydis", cacheHits(), cacheMisses());
+		return true;
+	}
 
 private:
 
-	bool decodeRaw(t::uint32 a) {
-		auto seg = image()->at(a);
-		if(seg == nullptr)
+	// per-segment storage of instructions
+	class Area {
+	public:
+		Area(const SegmentIndex::Entry& e): cache(e.base(), e.size()) { }
+		Arena arena;
+		InstCache cache;
+	};
+
+	const SegmentIndex::Entry *select(gel::address_t a) {
+		auto e = segments().at(a);
+		if(e != nullptr) {
+			if(!e->segment()->isExecutable())
+				return nullptr;
+			while(areas.count() <= e->index())
+				areas.add(nullptr);
+			if(areas[e->index()] == nullptr)
+				areas[e->index()] = new Area(*e);
+			if(stats != nullptr && area != areas[e->index()])
+				stats->segmentMiss();
+			area = areas[e->index()];
+		}
+		return e;
+	}
+
+	// decode from the stored bytes of the segment (the following ones are unknown)
+	bool decodeRaw(const SegmentIndex::Entry& e, gel::address_t a, ZydisDecodedInstruction& zi) {
+		t::uint32 o = a - e.base();
+		if(o >= e.available())
 			return false;
-		auto buf = seg->buffer();
 		auto r = ZydisDecoderDecodeBuffer(
 			&zdec,
-			buf.at(a - seg->baseAddress()),
-			seg->baseAddress() + seg->size() - a,
+			e.bytes() + o,
+			e.available() - o,
 			&zi);
 		return ZYAN_SUCCESS(r);
 	}
 
-	hard::Register *decodeReg(ZydisRegister r) {
-		switch(r) {
-		case ZYDIS_REGISTER_AL: 	return &AL;
-		case ZYDIS_REGISTER_CL:		return &CL;
-		case ZYDIS_REGISTER_DL:		return &DL;
-		case ZYDIS_REGISTER_BL:		return &BL;
-		case ZYDIS_REGISTER_AH:		return &AH;
-		case ZYDIS_REGISTER_CH:		return &CH;
-		case ZYDIS_REGISTER_DH:		return &DH;
-		case ZYDIS_REGISTER_BH:		return &BH;
-		//case ZYDIS_REGISTER_SPL:	return &SP;
-		//case ZYDIS_REGISTER_BPL:	return &BP;
-		case ZYDIS_REGISTER_AX:		return &AX;
-		case ZYDIS_REGISTER_CX:		return &CX;
-		case ZYDIS_REGISTER_DX:		return &DX;
-		case ZYDIS_REGISTER_BX:		return &BX;
-		case ZYDIS_REGISTER_SP:		return &SP;
-		case ZYDIS_REGISTER_BP:		return &BP;
-		case ZYDIS_REGISTER_SI:		return &SI;
-		case ZYDIS_REGISTER_DI:		return &DI;
-		case ZYDIS_REGISTER_EAX:	return &EAX;
-		case ZYDIS_REGISTER_ECX:	return &ECX;
-		case ZYDIS_REGISTER_EDX:	return &EDX;
-		case ZYDIS_REGISTER_EBX:	return &EBX;
-		case ZYDIS_REGISTER_ESP:	return &ESP;
-		case ZYDIS_REGISTER_EBP:	return &EBP;
-		case ZYDIS_REGISTER_ESI:	return &ESI;
-		case ZYDIS_REGISTER_EDI:	return &EDI;
-		case ZYDIS_REGISTER_EFLAGS:	return &EFLAGS;
-		case ZYDIS_REGISTER_IP:		return &IP;
-		case ZYDIS_REGISTER_EIP:	return &EIP;
-		default:
-			return nullptr;
+	// record a decoding in the statistics
+	void record(const SegmentIndex::Entry& e, gel::address_t a, bool done, const ZydisDecodedInstruction& zi, t::uint64 ns) {
+		stats->decoded(ns);
+		if(!done) {
+			stats->unknown(e.bytes() + (a - e.base()), e.bytes() + e.available(), _mode);
+			return;
 		}
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_LOCK)
+			stats->prefix(Stats::LOCK);
+		if(zi.attributes & (ZYDIS_ATTRIB_HAS_REP | ZYDIS_ATTRIB_HAS_REPE))
+			stats->prefix(Stats::REP);
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_REPNE)
+			stats->prefix(Stats::REPNE);
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_SEGMENT)
+			stats->prefix(Stats::SEGMENT);
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_OPERANDSIZE)
+			stats->prefix(Stats::OPSIZE);
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_ADDRESSSIZE)
+			stats->prefix(Stats::ADSIZE);
+		if(zi.attributes & ZYDIS_ATTRIB_HAS_REX)
+			stats->prefix(Stats::REX);
 	}
 
+	mode_t _mode;
 	ZydisDecoder zdec;
-	ZydisFormatter zform;
-	ZydisDecodedInstruction zi;
+	Area *area;
+	Vector<Area *> areas;
+	Stats *stats;
 };
 
-otawa::Decoder *makeDecoder(gel::Image *i) {
-	return new Decoder(i);
+}	// zydis
+
+otawa::Decoder *makeZydisDecoder(gel::Image *i, mode_t mode, bool stats) {
+	return new zydis::Decoder(i, mode, stats);
 }
 
 }}	// otawa::x86
-